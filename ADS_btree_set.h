@@ -0,0 +1,970 @@
+// macros
+#ifndef ADS_BTREE_SET_H
+#define ADS_BTREE_SET_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "ADS_set.h"
+
+/*
+-----------------
+B+-TREE
+-----------------
+ADS_btree_set is the ordered variant of the ADS_set interface (key_compare instead of hasher and key_equal, see Clean.h):
+iteration visits the keys in ascending order, lower_bound(), upper_bound() and range() find the start of a range in O(log size).
+* all keys are stored in the leaves, the inner nodes only hold separators: keys[i] is not greater than any key in children[i + 1]
+  and greater than every key in children[0 .. i]
+* every node keeps its keys contiguously in one array of NODE_KEYS keys (a leaf is NODE_BYTES, a few cache lines).
+  A node is searched without branches on the comparisons: a linear count for arithmetic keys (vectorized by the compiler),
+  a binary search whose comparison only selects the next half (conditional move) for all other keys
+* the leaves are linked in key order, so iteration and range scans walk from leaf to leaf without going back up the tree
+* sorted input is bulk loaded (range constructor, insert() of a range into an empty set, copies): the leaves are filled one after
+  the other and every inner level is built on top of the one below, O(size) instead of O(size * log size)
+* a key appended behind the largest key splits the last leaf unevenly (the full leaf stays full), so ascending inserts pack the leaves
+* erase() does not leave sparse nodes behind: a node that drops below NODE_KEYS / 2 keys takes a key from a neighbour
+  or is merged with it (merges may go up to the root, the tree then loses a level), so the height stays O(log size)
+-----------------
+N: keys per node, 0 (default): as many as fit into NODE_BYTES
+key_type has to be default constructible and move assignable (nodes hold arrays of keys).
+*/
+template <typename Key, size_t N = 0, typename Compare = std::less<Key>>
+class ADS_btree_set
+{
+public:
+    class Iterator;
+    class Range;
+    using value_type = Key;
+    using key_type = Key;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = Iterator; // invalidated by every insert() and erase() (keys move within their leaf)
+    using iterator = const_iterator;
+    using key_compare = Compare;
+
+private:
+    static constexpr size_type NODE_BYTES{256};
+    static constexpr size_type NODE_KEYS{N ? N : std::max(size_type{4}, (NODE_BYTES - 3 * sizeof(void *)) / sizeof(key_type))};
+    static constexpr size_type MAX_HEIGHT{64}; // every inner node has room for at least 4 children
+    static constexpr size_type MIN_KEYS{NODE_KEYS / 2}; // erase() refills or merges a node that drops below this many keys
+    static_assert(NODE_KEYS >= 3, "ADS_btree_set: a node needs room for at least 3 keys");
+
+    /* arithmetic keys compared with < are counted linearly, all others are searched binary */
+    static constexpr bool linear_search{std::is_arithmetic<key_type>::value &&
+                                        (std::is_same<key_compare, std::less<key_type>>::value || std::is_same<key_compare, std::less<>>::value)};
+
+    struct alignas(64) Leaf
+    {
+        key_type keys[NODE_KEYS];
+        size_type count{0}; // keys in use, never 0 (erase() merges a leaf before it is empty)
+        Leaf *previous{nullptr};
+        Leaf *next{nullptr};
+    };
+
+    /* count keys and count + 1 children: Leaf nodes in the lowest inner level, Inner nodes above it */
+    struct alignas(64) Inner
+    {
+        key_type keys[NODE_KEYS];
+        size_type count{0};
+        void *children[NODE_KEYS + 1];
+    };
+
+    void *root{nullptr};            // Leaf if height == 1, Inner if height > 1
+    size_type height{0};            // levels of nodes, 0 if the container is empty
+    Leaf *first_leaf{nullptr};      // smallest keys, begin()
+    size_type inserted_elements{0}; // how many elements have been inserted
+
+    /*
+    Number of leading keys in keys[0 .. count[ for which before(key) is true (before has to be true for a prefix of the keys)
+    */
+    template <typename Before>
+    static size_type partitionPoint(const key_type *keys, size_type count, Before before)
+    {
+        if constexpr (linear_search)
+        {
+            size_type index{0};
+            for (size_type position{0}; position < count; ++position)
+            {
+                index += before(keys[position]);
+            }
+            return index;
+        }
+        else
+        {
+            const key_type *base{keys};
+            size_type length{count};
+            while (length > 1)
+            {
+                size_type half{length / 2};
+                base = before(base[half]) ? base + half : base;
+                length -= half;
+            }
+            return size_type(base - keys) + (length == 1 && before(*base));
+        }
+    }
+
+    /* position of the first key in keys[0 .. count[ that is not less than key */
+    static size_type lowerIndex(const key_type *keys, size_type count, const key_type &key)
+    {
+        return partitionPoint(keys, count, [&key](const key_type &stored)
+                              { return key_compare{}(stored, key); });
+    }
+
+    /* position of the first key in keys[0 .. count[ that is greater than key, the child of an inner node that leads to key */
+    static size_type upperIndex(const key_type *keys, size_type count, const key_type &key)
+    {
+        return partitionPoint(keys, count, [&key](const key_type &stored)
+                              { return !key_compare{}(key, stored); });
+    }
+
+    /*
+    Leaf that holds key if it is stored. If path is given, path[level] and slots[level] are set to the inner nodes
+    and the children taken on the way down (level 0: root).
+    */
+    Leaf *leafFor(const key_type &key, Inner **path = nullptr, size_type *slots = nullptr) const;
+
+    /* first position at or behind position in leaf that holds a key (the next leaf if position is behind the last key) */
+    static Iterator normalized(const Leaf *leaf, size_type position)
+    {
+        if (position == leaf->count)
+        {
+            return Iterator{leaf->next, 0};
+        }
+        return Iterator{leaf, position};
+    }
+
+    /*
+    Implementation of insert(const key_type &) and insert(key_type &&)
+    */
+    template <typename K>
+    std::pair<iterator, bool> insertKey(K &&key);
+
+    /*
+    Builds the tree from count distinct keys in ascending order starting at first, the container must be empty.
+    The leaves are filled evenly, so no leaf is less than half full.
+    */
+    template <typename InputIt>
+    void bulkLoad(InputIt first, size_type count);
+
+    /*
+    Collects the keys of [first, last[, sorts them (equivalent keys: the first one is kept) and bulk loads them into the empty container
+    */
+    template <typename InputIt>
+    void loadUnsorted(InputIt first, InputIt last);
+
+    /* removes children[child] (child > 0) and the separator in front of it from inner */
+    static void removeChild(Inner *inner, size_type child)
+    {
+        std::move(inner->keys + child, inner->keys + inner->count, inner->keys + child - 1);
+        std::copy(inner->children + child + 1, inner->children + inner->count + 1, inner->children + child);
+        --inner->count;
+    }
+
+    /* frees node (on level, 1: leaf) and all nodes below it */
+    static void destroy(void *node, size_type level);
+
+public:
+    /* ------- CONSTRUCTORS ------- */
+
+    ADS_btree_set() = default;
+
+    ADS_btree_set(std::initializer_list<key_type> ilist)
+    {
+        loadUnsorted(ilist.begin(), ilist.end());
+    }
+
+    /*
+    Range constructor. The keys are sorted and bulk loaded. Complexity: O(range_size) if the range is sorted, O(range_size * log range_size) otherwise
+    */
+    template <typename InputIt>
+    ADS_btree_set(InputIt first, InputIt last)
+    {
+        loadUnsorted(first, last);
+    }
+
+    /* the copy is bulk loaded from the leaves of other, its nodes are packed again. Complexity: O(size) */
+    ADS_btree_set(const ADS_btree_set &other)
+    {
+        bulkLoad(other.begin(), other.size());
+    }
+
+    ADS_btree_set(ADS_btree_set &&other) noexcept
+    {
+        swap(other);
+    }
+
+    ~ADS_btree_set()
+    {
+        destroy(root, height);
+    }
+
+    ADS_btree_set &operator=(const ADS_btree_set &other)
+    {
+        ADS_btree_set temporary{other};
+        swap(temporary);
+        return *this;
+    }
+
+    ADS_btree_set &operator=(ADS_btree_set &&other) noexcept
+    {
+        ADS_btree_set temporary{std::move(other)};
+        swap(temporary);
+        return *this;
+    }
+
+    ADS_btree_set &operator=(std::initializer_list<key_type> ilist)
+    {
+        ADS_btree_set temporary{ilist};
+        swap(temporary);
+        return *this;
+    }
+
+    /* ------- PUBLIC METHODS ------- */
+
+    size_type size() const
+    {
+        return inserted_elements;
+    }
+
+    bool empty() const
+    {
+        return inserted_elements == 0;
+    }
+
+    /*
+    Inserts key. Return value: iterator on the key and true if it was inserted, false if an equivalent key was already stored.
+    Complexity: O(log size)
+    */
+    std::pair<iterator, bool> insert(const key_type &key)
+    {
+        return insertKey(key);
+    }
+
+    std::pair<iterator, bool> insert(key_type &&key)
+    {
+        return insertKey(std::move(key));
+    }
+
+    void insert(std::initializer_list<key_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    /*
+    Inserts the keys of [first, last[. An empty container is bulk loaded (see the range constructor).
+    Complexity: O(range_size * log (range_size + size))
+    */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        if (empty())
+        {
+            loadUnsorted(first, last);
+            return;
+        }
+        for (auto it{first}; it != last; ++it)
+        {
+            insert(*it);
+        }
+    }
+
+    /*
+    Removes all elements. Complexity: O(size)
+    */
+    void clear()
+    {
+        ADS_btree_set temporary;
+        swap(temporary);
+    }
+
+    /*
+    Removes the key. Return value: number of deleted elements (0 or 1). Complexity: O(log size)
+    */
+    size_type erase(const key_type &key);
+
+    size_type count(const key_type &key) const
+    {
+        return find(key) != end();
+    }
+
+    /*
+    Return value: an iterator on the key, or end() if it is not stored. Complexity: O(log size)
+    */
+    iterator find(const key_type &key) const
+    {
+        if (!root)
+        {
+            return end();
+        }
+        const Leaf *leaf{leafFor(key)};
+        size_type position{lowerIndex(leaf->keys, leaf->count, key)};
+        if (position == leaf->count || key_compare{}(key, leaf->keys[position]))
+        {
+            return end();
+        }
+        return Iterator{leaf, position};
+    }
+
+    /*
+    Return value: iterator on the first key that is not less than key, end() if there is none. Complexity: O(log size)
+    */
+    iterator lower_bound(const key_type &key) const
+    {
+        if (!root)
+        {
+            return end();
+        }
+        const Leaf *leaf{leafFor(key)};
+        return normalized(leaf, lowerIndex(leaf->keys, leaf->count, key));
+    }
+
+    /*
+    Return value: iterator on the first key that is greater than key, end() if there is none. Complexity: O(log size)
+    */
+    iterator upper_bound(const key_type &key) const
+    {
+        if (!root)
+        {
+            return end();
+        }
+        const Leaf *leaf{leafFor(key)};
+        return normalized(leaf, upperIndex(leaf->keys, leaf->count, key));
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type &key) const
+    {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    /*
+    Return value: the keys in [first, last[ in ascending order, e.g. for (const auto &key : set.range(10, 20)).
+    Empty if last is not greater than first. Complexity: O(log size) (plus the keys that are visited)
+    */
+    Range range(const key_type &first, const key_type &last) const
+    {
+        if (!key_compare{}(first, last))
+        {
+            return Range{end(), end()};
+        }
+        return Range{lower_bound(first), lower_bound(last)};
+    }
+
+    key_compare key_comp() const
+    {
+        return key_compare{};
+    }
+
+    const_iterator begin() const
+    {
+        return Iterator{first_leaf, 0};
+    }
+
+    const_iterator end() const
+    {
+        return Iterator{nullptr, 0};
+    }
+
+    void swap(ADS_btree_set &other) noexcept
+    {
+        std::swap(root, other.root);
+        std::swap(height, other.height);
+        std::swap(first_leaf, other.first_leaf);
+        std::swap(inserted_elements, other.inserted_elements);
+    }
+
+    /*
+    Output the nodes level by level (root first) to the stream o
+    */
+    void dump(std::ostream &o = std::cerr) const;
+
+    /* ------- OPERATORS ------- */
+
+    /* both containers hold their keys in order, so they are compared pairwise. Complexity: O(size) */
+    friend bool operator==(const ADS_btree_set &lhs, const ADS_btree_set &rhs)
+    {
+        if (lhs.inserted_elements != rhs.inserted_elements)
+        {
+            return false;
+        }
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const key_type &left, const key_type &right)
+                          { return !key_compare{}(left, right) && !key_compare{}(right, left); });
+    }
+
+    friend bool operator!=(const ADS_btree_set &lhs, const ADS_btree_set &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+/* ------- ITERATOR ------- */
+/*
+Walks the keys of a leaf and moves on to the next leaf behind its last key
+*/
+template <typename Key, size_t N, typename Compare>
+class ADS_btree_set<Key, N, Compare>::Iterator
+{
+private:
+    const Leaf *leaf{nullptr}; // nullptr: end()
+    size_type index{0};        // position in the keys of leaf
+
+    friend class ADS_btree_set;
+
+public:
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type &;
+    using pointer = const value_type *;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator() = default;
+
+    Iterator(const Leaf *leaf, size_type index) : leaf{leaf}, index{index} {}
+
+    reference operator*() const
+    {
+        return leaf->keys[index];
+    }
+
+    pointer operator->() const
+    {
+        return &leaf->keys[index];
+    }
+
+    Iterator &operator++()
+    {
+        if (++index == leaf->count)
+        {
+            leaf = leaf->next;
+            index = 0;
+        }
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator before{*this};
+        ++*this;
+        return before;
+    }
+
+    friend bool operator==(const Iterator &lhs, const Iterator &rhs)
+    {
+        return lhs.leaf == rhs.leaf && lhs.index == rhs.index;
+    }
+
+    friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+/* ------- RANGE ------- */
+/*
+Keys between two iterators, returned by range() so it can be used in a range based for loop
+*/
+template <typename Key, size_t N, typename Compare>
+class ADS_btree_set<Key, N, Compare>::Range
+{
+private:
+    Iterator first;
+    Iterator last;
+
+public:
+    Range(Iterator first, Iterator last) : first{first}, last{last} {}
+
+    Iterator begin() const
+    {
+        return first;
+    }
+
+    Iterator end() const
+    {
+        return last;
+    }
+
+    bool empty() const
+    {
+        return first == last;
+    }
+};
+
+/* ------- B+-TREE IMPLEMENTATION ------- */
+template <typename Key, size_t N, typename Compare>
+typename ADS_btree_set<Key, N, Compare>::Leaf *ADS_btree_set<Key, N, Compare>::leafFor(const key_type &key, Inner **path, size_type *slots) const
+{
+    void *node{root};
+    for (size_type level{0}; level + 1 < height; ++level)
+    {
+        Inner *inner{static_cast<Inner *>(node)};
+        size_type slot{upperIndex(inner->keys, inner->count, key)};
+        if (path)
+        {
+            path[level] = inner;
+            slots[level] = slot;
+        }
+        node = inner->children[slot];
+    }
+    return static_cast<Leaf *>(node);
+}
+
+template <typename Key, size_t N, typename Compare>
+template <typename K>
+std::pair<typename ADS_btree_set<Key, N, Compare>::iterator, bool> ADS_btree_set<Key, N, Compare>::insertKey(K &&key)
+{
+    if (!root)
+    {
+        std::unique_ptr<Leaf> leaf{new Leaf};
+        leaf->keys[0] = std::forward<K>(key);
+        leaf->count = 1;
+        first_leaf = leaf.get();
+        root = leaf.release();
+        height = 1;
+        inserted_elements = 1;
+        return {Iterator{first_leaf, 0}, true};
+    }
+
+    Inner *path[MAX_HEIGHT];
+    size_type slots[MAX_HEIGHT];
+    Leaf *leaf{leafFor(key, path, slots)};
+    size_type position{lowerIndex(leaf->keys, leaf->count, key)};
+    if (position < leaf->count && !key_compare{}(key, leaf->keys[position]))
+    {
+        return {Iterator{leaf, position}, false};
+    }
+
+    if (leaf->count < NODE_KEYS)
+    {
+        std::move_backward(leaf->keys + position, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        leaf->keys[position] = std::forward<K>(key);
+        ++leaf->count;
+        ++inserted_elements;
+        return {Iterator{leaf, position}, true};
+    }
+
+    // the leaf and every full inner node above it are split: all new nodes are allocated first, so a bad_alloc changes nothing
+    size_type full_levels{height - 1};
+    while (full_levels > 0 && path[full_levels - 1]->count == NODE_KEYS)
+    {
+        --full_levels;
+    }
+    const bool new_root{full_levels == 0};
+    std::unique_ptr<Leaf> right_leaf{new Leaf};
+    std::unique_ptr<Inner> right_inners[MAX_HEIGHT];
+    for (size_type level{full_levels}; level + 1 < height; ++level)
+    {
+        right_inners[level].reset(new Inner);
+    }
+    std::unique_ptr<Inner> root_inner{new_root ? new Inner : nullptr};
+    key_type inserted{std::forward<K>(key)};
+
+    // keys' = keys[0 .. position[, inserted, keys[position .. NODE_KEYS[: the left leaf keeps the first left_count of them.
+    // Appending behind the largest key leaves the full leaf as it is, so ascending inserts fill every leaf.
+    // The copies are made before the leaf changes, the rest of the split only moves keys.
+    const size_type left_count{position == NODE_KEYS && !leaf->next ? NODE_KEYS : (NODE_KEYS + 1) / 2};
+    key_type separator{left_count == position ? inserted : leaf->keys[left_count < position ? left_count : left_count - 1]};
+    Leaf *right{right_leaf.release()};
+    if (position >= left_count)
+    {
+        key_type *target{std::move(leaf->keys + left_count, leaf->keys + position, right->keys)};
+        *target++ = std::move(inserted);
+        std::move(leaf->keys + position, leaf->keys + NODE_KEYS, target);
+    }
+    else
+    {
+        std::move(leaf->keys + left_count - 1, leaf->keys + NODE_KEYS, right->keys);
+        std::move_backward(leaf->keys + position, leaf->keys + left_count - 1, leaf->keys + left_count);
+        leaf->keys[position] = std::move(inserted);
+    }
+    right->count = NODE_KEYS + 1 - left_count;
+    leaf->count = left_count;
+    right->previous = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+    {
+        leaf->next->previous = right;
+    }
+    leaf->next = right;
+    ++inserted_elements;
+    const Iterator result{position < left_count ? Iterator{leaf, position} : Iterator{right, position - left_count}};
+
+    // separator (keys'[left_count]) and the new leaf are inserted into the parent,
+    // a full parent is split in the same way (its middle key moves up)
+    void *child{right};
+    for (size_type level{height - 1}; level-- > 0;)
+    {
+        Inner *inner{path[level]};
+        const size_type slot{slots[level]};
+        if (inner->count < NODE_KEYS)
+        {
+            std::move_backward(inner->keys + slot, inner->keys + inner->count, inner->keys + inner->count + 1);
+            std::copy_backward(inner->children + slot + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+            inner->keys[slot] = std::move(separator);
+            inner->children[slot + 1] = child;
+            ++inner->count;
+            return {result, true};
+        }
+
+        // keys' has NODE_KEYS + 1 keys and NODE_KEYS + 2 children: the left node keeps left_keys keys, keys'[left_keys] moves up
+        const size_type left_keys{(NODE_KEYS + 1) / 2};
+        Inner *right_inner{right_inners[level].release()};
+        key_type middle;
+        if (slot > left_keys)
+        {
+            // the new key and child belong to the right node
+            middle = std::move(inner->keys[left_keys]);
+            key_type *target{std::move(inner->keys + left_keys + 1, inner->keys + slot, right_inner->keys)};
+            *target++ = std::move(separator);
+            std::move(inner->keys + slot, inner->keys + NODE_KEYS, target);
+            void **target_child{std::copy(inner->children + left_keys + 1, inner->children + slot + 1, right_inner->children)};
+            *target_child++ = child;
+            std::copy(inner->children + slot + 1, inner->children + NODE_KEYS + 1, target_child);
+        }
+        else if (slot == left_keys)
+        {
+            // the new key moves up, the new child becomes the first child of the right node
+            middle = std::move(separator);
+            std::move(inner->keys + left_keys, inner->keys + NODE_KEYS, right_inner->keys);
+            right_inner->children[0] = child;
+            std::copy(inner->children + left_keys + 1, inner->children + NODE_KEYS + 1, right_inner->children + 1);
+        }
+        else
+        {
+            // the new key and child belong to the left node
+            middle = std::move(inner->keys[left_keys - 1]);
+            std::move(inner->keys + left_keys, inner->keys + NODE_KEYS, right_inner->keys);
+            std::copy(inner->children + left_keys, inner->children + NODE_KEYS + 1, right_inner->children);
+            std::move_backward(inner->keys + slot, inner->keys + left_keys - 1, inner->keys + left_keys);
+            std::copy_backward(inner->children + slot + 1, inner->children + left_keys, inner->children + left_keys + 1);
+            inner->keys[slot] = std::move(separator);
+            inner->children[slot + 1] = child;
+        }
+        right_inner->count = NODE_KEYS - left_keys;
+        inner->count = left_keys;
+        separator = std::move(middle);
+        child = right_inner;
+    }
+
+    // the root was split as well: the tree grows by one level
+    Inner *top{root_inner.release()};
+    top->keys[0] = std::move(separator);
+    top->children[0] = root;
+    top->children[1] = child;
+    top->count = 1;
+    root = top;
+    ++height;
+    return {result, true};
+}
+
+template <typename Key, size_t N, typename Compare>
+typename ADS_btree_set<Key, N, Compare>::size_type ADS_btree_set<Key, N, Compare>::erase(const key_type &key)
+{
+    if (!root)
+    {
+        return 0;
+    }
+    Inner *path[MAX_HEIGHT];
+    size_type slots[MAX_HEIGHT];
+    Leaf *leaf{leafFor(key, path, slots)};
+    size_type position{lowerIndex(leaf->keys, leaf->count, key)};
+    if (position == leaf->count || key_compare{}(key, leaf->keys[position]))
+    {
+        return 0;
+    }
+    std::move(leaf->keys + position + 1, leaf->keys + leaf->count, leaf->keys + position);
+    --leaf->count;
+    --inserted_elements;
+    if (height == 1)
+    {
+        if (!leaf->count)
+        {
+            // the last key is gone
+            delete leaf;
+            root = nullptr;
+            first_leaf = nullptr;
+            height = 0;
+        }
+        return 1;
+    }
+    if (leaf->count >= MIN_KEYS)
+    {
+        return 1;
+    }
+
+    // the leaf takes a key from a neighbour with more than MIN_KEYS keys (below the same parent),
+    // otherwise the two leaves are merged. The new separator is copied before any key moves.
+    Inner *parent{path[height - 2]};
+    size_type slot{slots[height - 2]};
+    if (slot > 0 && static_cast<Leaf *>(parent->children[slot - 1])->count > MIN_KEYS)
+    {
+        Leaf *left{static_cast<Leaf *>(parent->children[slot - 1])};
+        key_type separator{left->keys[left->count - 1]};
+        std::move_backward(leaf->keys, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        leaf->keys[0] = std::move(left->keys[left->count - 1]);
+        --left->count;
+        ++leaf->count;
+        parent->keys[slot - 1] = std::move(separator);
+        return 1;
+    }
+    if (slot < parent->count && static_cast<Leaf *>(parent->children[slot + 1])->count > MIN_KEYS)
+    {
+        Leaf *right{static_cast<Leaf *>(parent->children[slot + 1])};
+        key_type separator{right->keys[1]};
+        leaf->keys[leaf->count] = std::move(right->keys[0]);
+        ++leaf->count;
+        std::move(right->keys + 1, right->keys + right->count, right->keys);
+        --right->count;
+        parent->keys[slot] = std::move(separator);
+        return 1;
+    }
+    // the right one of the two leaves moves its keys into the left one and is freed
+    size_type removed{slot ? slot : 1};
+    Leaf *left_leaf{static_cast<Leaf *>(parent->children[removed - 1])};
+    Leaf *right_leaf{static_cast<Leaf *>(parent->children[removed])};
+    std::move(right_leaf->keys, right_leaf->keys + right_leaf->count, left_leaf->keys + left_leaf->count);
+    left_leaf->count += right_leaf->count;
+    left_leaf->next = right_leaf->next;
+    if (right_leaf->next)
+    {
+        right_leaf->next->previous = left_leaf;
+    }
+    delete right_leaf;
+    removeChild(parent, removed);
+
+    // the parent lost a key: inner nodes are refilled or merged in the same way up to the root,
+    // the separator of the parent above rotates through the parent (or moves down into the merged node)
+    for (size_type level{height - 2}; level > 0 && parent->count < MIN_KEYS; --level)
+    {
+        Inner *node{parent};
+        parent = path[level - 1];
+        slot = slots[level - 1];
+        if (slot > 0 && static_cast<Inner *>(parent->children[slot - 1])->count > MIN_KEYS)
+        {
+            Inner *left{static_cast<Inner *>(parent->children[slot - 1])};
+            std::move_backward(node->keys, node->keys + node->count, node->keys + node->count + 1);
+            std::copy_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+            node->keys[0] = std::move(parent->keys[slot - 1]);
+            node->children[0] = left->children[left->count];
+            ++node->count;
+            parent->keys[slot - 1] = std::move(left->keys[left->count - 1]);
+            --left->count;
+            return 1;
+        }
+        if (slot < parent->count && static_cast<Inner *>(parent->children[slot + 1])->count > MIN_KEYS)
+        {
+            Inner *right{static_cast<Inner *>(parent->children[slot + 1])};
+            node->keys[node->count] = std::move(parent->keys[slot]);
+            node->children[node->count + 1] = right->children[0];
+            ++node->count;
+            parent->keys[slot] = std::move(right->keys[0]);
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            std::copy(right->children + 1, right->children + right->count + 1, right->children);
+            --right->count;
+            return 1;
+        }
+        removed = slot ? slot : 1;
+        Inner *left{static_cast<Inner *>(parent->children[removed - 1])};
+        Inner *right{static_cast<Inner *>(parent->children[removed])};
+        left->keys[left->count] = std::move(parent->keys[removed - 1]);
+        std::move(right->keys, right->keys + right->count, left->keys + left->count + 1);
+        std::copy(right->children, right->children + right->count + 1, left->children + left->count + 1);
+        left->count += right->count + 1;
+        delete right;
+        removeChild(parent, removed);
+    }
+
+    // a root with a single child is replaced by the child
+    if (parent == root && parent->count == 0)
+    {
+        root = parent->children[0];
+        delete parent;
+        --height;
+    }
+    return 1;
+}
+
+template <typename Key, size_t N, typename Compare>
+template <typename InputIt>
+void ADS_btree_set<Key, N, Compare>::bulkLoad(InputIt first, size_type count)
+{
+    if (!count)
+    {
+        return;
+    }
+    // nodes built so far are freed if a key cannot be copied or a node cannot be allocated
+    std::vector<void *> level;        // nodes of the level that is built
+    std::vector<const key_type *> lows; // smallest key in the subtree of every node of level
+    std::vector<void *> above;
+    std::vector<const key_type *> above_lows;
+    size_type levels{0};
+    Leaf *leftmost{nullptr};
+    try
+    {
+        size_type leaf_count{(count + NODE_KEYS - 1) / NODE_KEYS};
+        level.reserve(leaf_count);
+        lows.reserve(leaf_count);
+        Leaf *previous{nullptr};
+        for (size_type leaf_index{0}; leaf_index < leaf_count; ++leaf_index)
+        {
+            Leaf *leaf{new Leaf};
+            level.push_back(leaf);
+            leaf->previous = previous;
+            if (previous)
+            {
+                previous->next = leaf;
+            }
+            else
+            {
+                leftmost = leaf;
+            }
+            previous = leaf;
+            const size_type keys{count / leaf_count + (leaf_index < count % leaf_count)};
+            for (; leaf->count < keys; ++leaf->count, ++first)
+            {
+                leaf->keys[leaf->count] = *first;
+            }
+            lows.push_back(leaf->keys);
+        }
+        levels = 1;
+
+        while (level.size() > 1)
+        {
+            const size_type node_count{(level.size() + NODE_KEYS) / (NODE_KEYS + 1)};
+            above.clear();
+            above_lows.clear();
+            above.reserve(node_count);
+            above_lows.reserve(node_count);
+            size_type child_index{0};
+            for (size_type node_index{0}; node_index < node_count; ++node_index)
+            {
+                Inner *inner{new Inner};
+                above.push_back(inner);
+                above_lows.push_back(lows[child_index]);
+                const size_type children{level.size() / node_count + (node_index < level.size() % node_count)};
+                inner->children[0] = level[child_index++];
+                for (; inner->count + 1 < children; ++inner->count, ++child_index)
+                {
+                    inner->keys[inner->count] = *lows[child_index];
+                    inner->children[inner->count + 1] = level[child_index];
+                }
+            }
+            level.swap(above);
+            lows.swap(above_lows);
+            ++levels;
+        }
+    }
+    catch (...)
+    {
+        if (levels == 0)
+        {
+            // the leaves are linked, but not below any inner node yet
+            for (void *leaf : level)
+            {
+                delete static_cast<Leaf *>(leaf);
+            }
+        }
+        else
+        {
+            // every node of level owns its subtree, the nodes of the unfinished level above own the children they took
+            size_type owned{0};
+            for (void *node : above)
+            {
+                owned += static_cast<Inner *>(node)->count + 1;
+                destroy(node, levels + 1);
+            }
+            for (size_type index{owned}; index < level.size(); ++index)
+            {
+                destroy(level[index], levels);
+            }
+        }
+        throw;
+    }
+    root = level[0];
+    height = levels;
+    first_leaf = leftmost;
+    inserted_elements = count;
+}
+
+template <typename Key, size_t N, typename Compare>
+template <typename InputIt>
+void ADS_btree_set<Key, N, Compare>::loadUnsorted(InputIt first, InputIt last)
+{
+    std::vector<key_type> keys(first, last);
+    if (!std::is_sorted(keys.begin(), keys.end(), key_compare{}))
+    {
+        std::stable_sort(keys.begin(), keys.end(), key_compare{});
+    }
+    keys.erase(std::unique(keys.begin(), keys.end(), [](const key_type &left, const key_type &right)
+                           { return !key_compare{}(left, right); }),
+               keys.end());
+    bulkLoad(std::make_move_iterator(keys.begin()), keys.size());
+}
+
+template <typename Key, size_t N, typename Compare>
+void ADS_btree_set<Key, N, Compare>::destroy(void *node, size_type level)
+{
+    if (!node)
+    {
+        return;
+    }
+    if (level == 1)
+    {
+        delete static_cast<Leaf *>(node);
+        return;
+    }
+    Inner *inner{static_cast<Inner *>(node)};
+    for (size_type index{0}; index <= inner->count; ++index)
+    {
+        destroy(inner->children[index], level - 1);
+    }
+    delete inner;
+}
+
+template <typename Key, size_t N, typename Compare>
+void ADS_btree_set<Key, N, Compare>::dump(std::ostream &o) const
+{
+    o << "size = " << inserted_elements << ", height = " << height << ", keys per node = " << NODE_KEYS << "\n";
+    std::vector<const void *> level;
+    if (root)
+    {
+        level.push_back(root);
+    }
+    for (size_type depth{1}; depth <= height; ++depth)
+    {
+        std::vector<const void *> below;
+        o << "level " << depth << ":";
+        for (const void *node : level)
+        {
+            if (depth == height)
+            {
+                const Leaf *leaf{static_cast<const Leaf *>(node)};
+                o << " [";
+                for (size_type index{0}; index < leaf->count; ++index)
+                {
+                    o << (index ? " " : "") << leaf->keys[index];
+                }
+                o << "]";
+                continue;
+            }
+            const Inner *inner{static_cast<const Inner *>(node)};
+            o << " [";
+            for (size_type index{0}; index < inner->count; ++index)
+            {
+                o << (index ? " " : "") << inner->keys[index];
+            }
+            o << "]";
+            below.insert(below.end(), inner->children, inner->children + inner->count + 1);
+        }
+        o << "\n";
+        level.swap(below);
+    }
+    o << "\n";
+}
+
+/* moves only swap pointers */
+static_assert(std::is_nothrow_move_constructible<ADS_btree_set<int>>::value && std::is_nothrow_move_assignable<ADS_btree_set<int>>::value,
+              "ADS_btree_set: move has to be noexcept");
+
+#endif // ADS_BTREE_SET_H
@@ -0,0 +1,216 @@
+// macros
+#ifndef ADS_CONCURRENT_SET_H
+#define ADS_CONCURRENT_SET_H
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+
+#include "ADS_set.h"
+
+/*
+-----------------
+LOCK STRIPING
+-----------------
+ADS_concurrent_set is a thread safe set built from SHARDS separate chaining ADS_sets.
+Every key belongs to exactly one shard (chosen by the high bits of its mixed hash value) and every shard
+is guarded by its own reader/writer lock:
+* count() and find() only take the shared lock of one shard, so readers never block each other
+* insert() and erase() take the exclusive lock of one shard, writers on different shards run in parallel
+* a shard grows (rehashes) while holding its own lock, so a growth step only blocks 1/SHARDS of the keys
+* every key is hashed once, the same hash value picks the shard and the bucket within it
+Iterators are not offered because they could not stay valid while other threads write: find() returns a copy of the key,
+for_each() visits all keys shard by shard under the shared lock.
+-----------------
+N: the initial size of the hash table of every shard
+SHARDS: number of shards (and locks), a power of two
+*/
+template <typename Key, size_t N = 7, size_t SHARDS = 64>
+class ADS_concurrent_set
+{
+public:
+    using shard_type = ADS_set<Key, N>;
+    using value_type = Key;
+    using key_type = Key;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t;
+    using key_equal = typename shard_type::key_equal;
+    using hasher = typename shard_type::hasher;
+
+    static_assert(SHARDS > 0 && (SHARDS & (SHARDS - 1)) == 0, "SHARDS has to be a power of two");
+
+private:
+    /*
+    one cache line per shard, so that threads working on neighbouring shards do not invalidate each other's lock
+    */
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        shard_type set;
+    };
+
+    Shard shards[SHARDS];
+
+    /*
+    The shard is taken from bits 32 and up of hash_value * 2^64 / golden ratio, the shard picks the bucket from the low bits
+    of hash_value itself (hasher is ADS_hash by default, which mixes the key's std::hash with ADS_mix).
+    Every product bit depends on all bits of hash_value below it (the carries of the multiplication), so the shard bits
+    are not a copy of the low bits that pick the bucket: the keys of one shard are still spread over all of its buckets.
+    */
+    static size_type shardIndex(size_type hash_value)
+    {
+        const uint64_t product{uint64_t(hash_value) * 0x9e3779b97f4a7c15ULL};
+        return size_type(product >> 32) & (SHARDS - 1);
+    }
+
+public:
+    /* ------- CONSTRUCTORS ------- */
+
+    ADS_concurrent_set() = default;
+
+    ADS_concurrent_set(std::initializer_list<key_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    template <typename InputIt>
+    ADS_concurrent_set(InputIt first, InputIt last)
+    {
+        insert(first, last);
+    }
+
+    /* the locks cannot be copied or moved */
+    ADS_concurrent_set(const ADS_concurrent_set &) = delete;
+    ADS_concurrent_set &operator=(const ADS_concurrent_set &) = delete;
+
+    /* ------- PUBLIC METHODS ------- */
+
+    /*
+    Inserts key. Return value: true if the key was inserted, false if it was already stored.
+    */
+    bool insert(const key_type &key)
+    {
+        const size_type full_hash{hasher{}(key)};
+        Shard &shard{shards[shardIndex(full_hash)]};
+        std::unique_lock<std::shared_mutex> lock{shard.mutex};
+        return shard.set.insertKey(key, full_hash).second;
+    }
+
+    /*
+    Inserts the elements from the range [first, last[. Every key locks only its own shard.
+    */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (auto it{first}; it != last; ++it)
+        {
+            insert(*it);
+        }
+    }
+
+    /*
+    Return value: number of deleted elements (0 or 1)
+    */
+    size_type erase(const key_type &key)
+    {
+        const size_type full_hash{hasher{}(key)};
+        Shard &shard{shards[shardIndex(full_hash)]};
+        std::unique_lock<std::shared_mutex> lock{shard.mutex};
+        return shard.set.eraseKey(key, full_hash);
+    }
+
+    /*
+    Return value: The number of elements in the container with key (0 or 1). Only takes a shared lock.
+    */
+    size_type count(const key_type &key) const
+    {
+        const size_type full_hash{hasher{}(key)};
+        const Shard &shard{shards[shardIndex(full_hash)]};
+        size_type bucket;
+        std::shared_lock<std::shared_mutex> lock{shard.mutex};
+        return shard.set.locate(key, full_hash, bucket) ? 1 : 0;
+    }
+
+    /*
+    Return value: a copy of the stored key that is equal to key, empty if there is none. Only takes a shared lock.
+    (An iterator or a reference could not stay valid once the lock is released.)
+    */
+    std::optional<key_type> find(const key_type &key) const
+    {
+        const size_type full_hash{hasher{}(key)};
+        const Shard &shard{shards[shardIndex(full_hash)]};
+        size_type bucket;
+        std::shared_lock<std::shared_mutex> lock{shard.mutex};
+        if (const auto *element{shard.set.locate(key, full_hash, bucket)})
+        {
+            return element->key;
+        }
+        return std::nullopt;
+    }
+
+    /*
+    Number of stored elements. The shards are counted one after the other, so while other threads write
+    the result is only a snapshot of each shard at the time it was counted.
+    */
+    size_type size() const
+    {
+        size_type total{0};
+        for (const Shard &shard : shards)
+        {
+            std::shared_lock<std::shared_mutex> lock{shard.mutex};
+            total += shard.set.size();
+        }
+        return total;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /*
+    Removes all elements, shard by shard
+    */
+    void clear()
+    {
+        for (Shard &shard : shards)
+        {
+            std::unique_lock<std::shared_mutex> lock{shard.mutex};
+            shard.set.clear();
+        }
+    }
+
+    /*
+    Calls function(key) for every stored key. Every shard is visited under its shared lock,
+    function must not modify this set.
+    */
+    template <typename Function>
+    void for_each(Function function) const
+    {
+        for (const Shard &shard : shards)
+        {
+            std::shared_lock<std::shared_mutex> lock{shard.mutex};
+            for (const auto &key : shard.set)
+            {
+                function(key);
+            }
+        }
+    }
+
+    /*
+    Output the contents of every shard to the stream o
+    */
+    void dump(std::ostream &o = std::cerr) const
+    {
+        for (size_type index{0}; index < SHARDS; ++index)
+        {
+            std::shared_lock<std::shared_mutex> lock{shards[index].mutex};
+            o << "shard " << index << ": ";
+            shards[index].set.dump(o);
+        }
+    }
+};
+
+#endif // ADS_CONCURRENT_SET_H
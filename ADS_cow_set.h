@@ -0,0 +1,597 @@
+// macros
+#ifndef ADS_COW_SET_H
+#define ADS_COW_SET_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ADS_set.h"
+
+/*
+-----------------
+COPY ON WRITE SNAPSHOTS
+-----------------
+ADS_cow_set is a hash set whose snapshot() is O(1): a snapshot is a read only view of the contents at the time it was taken,
+it stays valid and unchanged while the set keeps being written, and it can be read from other threads without any lock.
+The buckets are grouped into segments of SEGMENT_BUCKETS buckets. A segment stores the keys of its buckets in one array
+(bucket by bucket, offsets tells where every bucket starts), the set holds a directory with one pointer per segment.
+Directory and segments are reference counted and shared between the set and its snapshots:
+* snapshot() only takes another reference to the directory
+* the first write after a snapshot copies the directory (one pointer per segment, the segments stay shared)
+* a write copies the segment it changes if a snapshot still uses it, segments nobody else uses are changed in place
+So a writer copies only the segments it touches, and a scan or serialisation of a snapshot never blocks the writer.
+Growing the table builds new segments (split by one more hash bit), the snapshots keep the old ones. Only the keys of segments
+a snapshot still uses are copied for that, all others are moved.
+-----------------
+N: minimum number of buckets (rounded up to a whole segment)
+snapshot() has to be called by the writer (or under the same lock as the writes); the returned Snapshot can be used anywhere.
+*/
+template <typename Key, size_t N = 7, typename Hash = ADS_hash<Key>, typename KeyEqual = std::equal_to<>>
+class ADS_cow_set
+{
+public:
+    class Iterator;
+    class Snapshot;
+    using value_type = Key;
+    using key_type = Key;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = Iterator; // invalidated by every write to the set, never by a write to another set or snapshot
+    using iterator = const_iterator;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+
+private:
+    static constexpr size_type SEGMENT_BUCKETS{64};
+    static constexpr float MAX_LOAD_FACTOR{1.0};
+
+    /* keys of bucket b (within the segment) are keys[offsets[b]] ... keys[offsets[b + 1] - 1] */
+    struct Segment
+    {
+        std::vector<key_type> keys;
+        std::array<uint32_t, SEGMENT_BUCKETS + 1> offsets{};
+    };
+
+    using segment_ptr = std::shared_ptr<Segment>; // nullptr: all buckets of the segment are empty
+    using Directory = std::vector<segment_ptr>;
+
+    std::shared_ptr<Directory> directory; // nullptr: nothing stored yet (new, moved from, cleared), the first insert() creates it
+    size_type bucket_count{0}; // power of two, a multiple of SEGMENT_BUCKETS
+    size_type inserted_elements{0};
+
+    static size_type bucketCountFor(size_type n)
+    {
+        size_type count{SEGMENT_BUCKETS};
+        while (count < n)
+        {
+            count *= 2;
+        }
+        return count;
+    }
+
+    static size_type bucketOf(const key_type &key, size_type buckets)
+    {
+        size_type hash_value{hasher{}(key)};
+        if constexpr (!ADS_is_avalanching<hasher>::value)
+        {
+            hash_value = ADS_mix(hash_value);
+        }
+        return hash_value & (buckets - 1);
+    }
+
+    /*
+    Return value: pointer to the stored key, nullptr if it is not stored in directory (with buckets buckets, may be nullptr).
+    Shared by the set and its snapshots.
+    */
+    static const key_type *locate(const Directory *directory, size_type buckets, const key_type &key);
+
+    /* iterator on the first key (begin) or behind the last one of directory (may be nullptr) */
+    static Iterator beginOf(const Directory *directory)
+    {
+        return directory ? Iterator{directory->data(), directory->data() + directory->size()} : Iterator{};
+    }
+
+    static Iterator endOf(const Directory *directory)
+    {
+        return directory ? Iterator{directory->data() + directory->size(), directory->data() + directory->size()} : Iterator{};
+    }
+
+    /*
+    true if ptr is the only reference to its object, the object may then be changed in place.
+    The fence makes the reads of a snapshot that just released its reference (in another thread) happen before the change.
+    */
+    template <typename T>
+    static bool unique(const std::shared_ptr<T> &ptr)
+    {
+        if (ptr.use_count() != 1)
+        {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    /* segment segment_index, ready to be changed: the directory and the segment are copied if a snapshot still uses them */
+    Segment &writableSegment(size_type segment_index);
+
+    /* doubles bucket_count until n keys fit, every segment is split into two new ones */
+    void grow(size_type n);
+
+public:
+    /* ------- CONSTRUCTORS ------- */
+
+    /* allocates nothing, the directory is created by the first insert() */
+    ADS_cow_set() noexcept : bucket_count{bucketCountFor(N)} {}
+
+    ADS_cow_set(std::initializer_list<key_type> ilist) : ADS_cow_set{}
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    template <typename InputIt>
+    ADS_cow_set(InputIt first, InputIt last) : ADS_cow_set{}
+    {
+        insert(first, last);
+    }
+
+    /* a copy shares all segments with other, like a snapshot that can be written */
+    ADS_cow_set(const ADS_cow_set &other) = default;
+
+    /* other is left empty. Complexity: O(1) */
+    ADS_cow_set(ADS_cow_set &&other) noexcept : ADS_cow_set{}
+    {
+        swap(other);
+    }
+
+    ADS_cow_set &operator=(const ADS_cow_set &other)
+    {
+        ADS_cow_set temporary{other};
+        swap(temporary);
+        return *this;
+    }
+
+    ADS_cow_set &operator=(ADS_cow_set &&other) noexcept
+    {
+        ADS_cow_set temporary{std::move(other)};
+        swap(temporary);
+        return *this;
+    }
+
+    /* ------- PUBLIC METHODS ------- */
+
+    /*
+    Inserts key. Return value: true if the key was inserted, false if it was already stored.
+    Copies the segment of the key if a snapshot uses it. Complexity: O(SEGMENT_BUCKETS) (keys of the segment move)
+    */
+    bool insert(const key_type &key);
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (auto it{first}; it != last; ++it)
+        {
+            insert(*it);
+        }
+    }
+
+    /*
+    Return value: number of deleted elements (0 or 1). A segment is only copied if it holds the key.
+    */
+    size_type erase(const key_type &key);
+
+    /*
+    Removes all elements. The snapshots keep theirs.
+    */
+    void clear()
+    {
+        ADS_cow_set temporary;
+        swap(temporary);
+    }
+
+    size_type count(const key_type &key) const
+    {
+        return locate(directory.get(), bucket_count, key) ? 1 : 0;
+    }
+
+    size_type size() const
+    {
+        return inserted_elements;
+    }
+
+    bool empty() const
+    {
+        return inserted_elements == 0;
+    }
+
+    /*
+    Return value: read only view of the current contents. Complexity: O(1)
+    */
+    Snapshot snapshot() const
+    {
+        return Snapshot{directory, bucket_count, inserted_elements};
+    }
+
+    const_iterator begin() const
+    {
+        return beginOf(directory.get());
+    }
+
+    const_iterator end() const
+    {
+        return endOf(directory.get());
+    }
+
+    void swap(ADS_cow_set &other) noexcept
+    {
+        directory.swap(other.directory);
+        std::swap(bucket_count, other.bucket_count);
+        std::swap(inserted_elements, other.inserted_elements);
+    }
+
+    /*
+    Output the segments and their buckets to the stream o. Segments shared with a snapshot are marked.
+    */
+    void dump(std::ostream &o = std::cerr) const;
+
+    /* ------- OPERATORS ------- */
+
+    friend bool operator==(const ADS_cow_set &lhs, const ADS_cow_set &rhs)
+    {
+        if (lhs.inserted_elements != rhs.inserted_elements)
+        {
+            return false;
+        }
+        for (const auto &key : lhs)
+        {
+            if (!rhs.count(key))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const ADS_cow_set &lhs, const ADS_cow_set &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+/* ------- SNAPSHOT ------- */
+/*
+Read only contents of an ADS_cow_set at the time of snapshot(). Copying a snapshot is O(1) as well.
+All methods may be called from any number of threads at the same time, also while the set is written.
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+class ADS_cow_set<Key, N, Hash, KeyEqual>::Snapshot
+{
+private:
+    std::shared_ptr<const Directory> directory;
+    size_type bucket_count;
+    size_type inserted_elements;
+
+    friend class ADS_cow_set;
+
+    Snapshot(std::shared_ptr<const Directory> directory, size_type bucket_count, size_type inserted_elements)
+        : directory{std::move(directory)}, bucket_count{bucket_count}, inserted_elements{inserted_elements} {}
+
+public:
+    size_type count(const key_type &key) const
+    {
+        return locate(directory.get(), bucket_count, key) ? 1 : 0;
+    }
+
+    size_type size() const
+    {
+        return inserted_elements;
+    }
+
+    bool empty() const
+    {
+        return inserted_elements == 0;
+    }
+
+    const_iterator begin() const
+    {
+        return beginOf(directory.get());
+    }
+
+    const_iterator end() const
+    {
+        return endOf(directory.get());
+    }
+};
+
+/* ------- ITERATOR ------- */
+/*
+Walks the keys segment by segment, empty segments are skipped
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+class ADS_cow_set<Key, N, Hash, KeyEqual>::Iterator
+{
+private:
+    const segment_ptr *segment;
+    const segment_ptr *segments_end;
+    size_type index{0}; // position in the keys of *segment
+
+    /* moves on to the next segment with keys if the current one has no key at index */
+    void skip()
+    {
+        while (segment != segments_end && (!*segment || index == (*segment)->keys.size()))
+        {
+            ++segment;
+            index = 0;
+        }
+    }
+
+public:
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type &;
+    using pointer = const value_type *;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator() : segment{nullptr}, segments_end{nullptr} {}
+
+    Iterator(const segment_ptr *segment, const segment_ptr *segments_end) : segment{segment}, segments_end{segments_end}
+    {
+        skip();
+    }
+
+    reference operator*() const
+    {
+        return (*segment)->keys[index];
+    }
+
+    pointer operator->() const
+    {
+        return &(*segment)->keys[index];
+    }
+
+    Iterator &operator++()
+    {
+        ++index;
+        skip();
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator before{*this};
+        ++*this;
+        return before;
+    }
+
+    friend bool operator==(const Iterator &lhs, const Iterator &rhs)
+    {
+        return lhs.segment == rhs.segment && lhs.index == rhs.index;
+    }
+
+    friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+/* ------- COPY ON WRITE SET IMPLEMENTATION ------- */
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+const Key *ADS_cow_set<Key, N, Hash, KeyEqual>::locate(const Directory *directory, size_type buckets, const key_type &key)
+{
+    if (!directory)
+    {
+        return nullptr;
+    }
+    size_type bucket{bucketOf(key, buckets)};
+    const Segment *segment{(*directory)[bucket / SEGMENT_BUCKETS].get()};
+    if (!segment)
+    {
+        return nullptr;
+    }
+    bucket %= SEGMENT_BUCKETS;
+    for (size_type index{segment->offsets[bucket]}; index < segment->offsets[bucket + 1]; ++index)
+    {
+        if (key_equal{}(segment->keys[index], key))
+        {
+            return &segment->keys[index];
+        }
+    }
+    return nullptr;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+typename ADS_cow_set<Key, N, Hash, KeyEqual>::Segment &ADS_cow_set<Key, N, Hash, KeyEqual>::writableSegment(size_type segment_index)
+{
+    if (!directory)
+    {
+        directory = std::make_shared<Directory>(bucket_count / SEGMENT_BUCKETS);
+    }
+    else if (!unique(directory))
+    {
+        directory = std::make_shared<Directory>(*directory);
+    }
+    segment_ptr &segment{(*directory)[segment_index]};
+    if (!segment)
+    {
+        segment = std::make_shared<Segment>();
+    }
+    else if (!unique(segment))
+    {
+        segment = std::make_shared<Segment>(*segment);
+    }
+    return *segment;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+void ADS_cow_set<Key, N, Hash, KeyEqual>::grow(size_type n)
+{
+    while (bucket_count * MAX_LOAD_FACTOR < n)
+    {
+        if (!directory)
+        {
+            bucket_count *= 2; // nothing stored yet, writableSegment() creates the directory with this size
+            continue;
+        }
+        // bucket b of segment s goes to bucket b of segment s or of segment s + segment_count (one more hash bit),
+        // so the keys reach the new segments in bucket order and are simply appended.
+        // 1. every key is hashed and the new segments are allocated with their final size: only this step may throw
+        const size_type segment_count{directory->size()};
+        auto new_directory{std::make_shared<Directory>(segment_count * 2)};
+        std::vector<std::vector<bool>> goes_high(segment_count);
+        std::vector<bool> owned(segment_count); // no snapshot uses the segment, its keys are moved instead of copied
+        const bool owned_directory{unique(directory)};
+        for (size_type segment_index{0}; segment_index < segment_count; ++segment_index)
+        {
+            const segment_ptr &segment{(*directory)[segment_index]};
+            if (!segment)
+            {
+                continue;
+            }
+            owned[segment_index] = owned_directory && unique(segment);
+            goes_high[segment_index].resize(segment->keys.size());
+            size_type high_count{0};
+            for (size_type index{0}; index < segment->keys.size(); ++index)
+            {
+                const bool high{bucketOf(segment->keys[index], bucket_count * 2) >= bucket_count};
+                goes_high[segment_index][index] = high;
+                high_count += high;
+            }
+            if (high_count < segment->keys.size())
+            {
+                auto low{std::make_shared<Segment>()};
+                low->keys.reserve(segment->keys.size() - high_count);
+                (*new_directory)[segment_index] = std::move(low);
+            }
+            if (high_count)
+            {
+                auto high{std::make_shared<Segment>()};
+                high->keys.reserve(high_count);
+                (*new_directory)[segment_index + segment_count] = std::move(high);
+            }
+        }
+
+        // 2. the segments a snapshot still uses are copied (a copy may throw, nothing has been moved yet),
+        // then the keys of the others are moved (copied if their move may throw)
+        for (const bool move : {false, true})
+        {
+            for (size_type segment_index{0}; segment_index < segment_count; ++segment_index)
+            {
+                Segment *segment{(*directory)[segment_index].get()};
+                if (!segment || owned[segment_index] != move)
+                {
+                    continue;
+                }
+                Segment *low{(*new_directory)[segment_index].get()};
+                Segment *high{(*new_directory)[segment_index + segment_count].get()};
+                for (size_type bucket{0}; bucket < SEGMENT_BUCKETS; ++bucket)
+                {
+                    for (size_type index{segment->offsets[bucket]}; index < segment->offsets[bucket + 1]; ++index)
+                    {
+                        std::vector<key_type> &keys{(goes_high[segment_index][index] ? high : low)->keys};
+                        if (move)
+                        {
+                            keys.push_back(std::move_if_noexcept(segment->keys[index]));
+                        }
+                        else
+                        {
+                            keys.push_back(segment->keys[index]);
+                        }
+                    }
+                    if (low)
+                    {
+                        low->offsets[bucket + 1] = uint32_t(low->keys.size());
+                    }
+                    if (high)
+                    {
+                        high->offsets[bucket + 1] = uint32_t(high->keys.size());
+                    }
+                }
+            }
+        }
+        directory = std::move(new_directory);
+        bucket_count *= 2;
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+bool ADS_cow_set<Key, N, Hash, KeyEqual>::insert(const key_type &key)
+{
+    if (locate(directory.get(), bucket_count, key))
+    {
+        return false; // nothing is copied for a key that is already stored
+    }
+    grow(inserted_elements + 1);
+    size_type bucket{bucketOf(key, bucket_count)};
+    Segment &segment{writableSegment(bucket / SEGMENT_BUCKETS)};
+    bucket %= SEGMENT_BUCKETS;
+    // the key is put at the end of its bucket, the keys of the following buckets move up by one
+    segment.keys.insert(segment.keys.begin() + std::ptrdiff_t(segment.offsets[bucket + 1]), key);
+    for (size_type next{bucket + 1}; next <= SEGMENT_BUCKETS; ++next)
+    {
+        ++segment.offsets[next];
+    }
+    ++inserted_elements;
+    return true;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+typename ADS_cow_set<Key, N, Hash, KeyEqual>::size_type ADS_cow_set<Key, N, Hash, KeyEqual>::erase(const key_type &key)
+{
+    const key_type *stored{locate(directory.get(), bucket_count, key)};
+    if (!stored)
+    {
+        return 0;
+    }
+    size_type bucket{bucketOf(key, bucket_count)};
+    const Segment &shared{*(*directory)[bucket / SEGMENT_BUCKETS]};
+    size_type position{size_type(stored - shared.keys.data())}; // the same in a copy of the segment
+    Segment &segment{writableSegment(bucket / SEGMENT_BUCKETS)};
+    bucket %= SEGMENT_BUCKETS;
+    segment.keys.erase(segment.keys.begin() + std::ptrdiff_t(position));
+    for (size_type next{bucket + 1}; next <= SEGMENT_BUCKETS; ++next)
+    {
+        --segment.offsets[next];
+    }
+    --inserted_elements;
+    return 1;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual>
+void ADS_cow_set<Key, N, Hash, KeyEqual>::dump(std::ostream &o) const
+{
+    o << "bucket_count = " << bucket_count << ", inserted_elements = " << inserted_elements
+      << ", directory shared: " << (directory.use_count() > 1 ? "yes" : "no") << "\n";
+    for (size_type segment_index{0}; directory && segment_index < directory->size(); ++segment_index)
+    {
+        const segment_ptr &segment{(*directory)[segment_index]};
+        if (!segment)
+        {
+            continue;
+        }
+        o << "segment " << segment_index << (segment.use_count() > 1 ? " (shared)" : "") << ":\n";
+        for (size_type bucket{0}; bucket < SEGMENT_BUCKETS; ++bucket)
+        {
+            if (segment->offsets[bucket] == segment->offsets[bucket + 1])
+            {
+                continue;
+            }
+            o << segment_index * SEGMENT_BUCKETS + bucket << ": [";
+            for (size_type index{segment->offsets[bucket]}; index < segment->offsets[bucket + 1]; ++index)
+            {
+                o << (index == segment->offsets[bucket] ? "" : " -> ") << segment->keys[index];
+            }
+            o << "]\n";
+        }
+    }
+    o << "\n";
+}
+
+/* moves only swap pointers */
+static_assert(std::is_nothrow_move_constructible<ADS_cow_set<int>>::value && std::is_nothrow_move_assignable<ADS_cow_set<int>>::value,
+              "ADS_cow_set: move has to be noexcept");
+
+#endif // ADS_COW_SET_H
@@ -0,0 +1,345 @@
+// macros
+#ifndef ADS_FROZEN_SET_H
+#define ADS_FROZEN_SET_H
+
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "ADS_set.h"
+
+/*
+-----------------
+PERFECT HASHING
+-----------------
+ADS_frozen_set is an immutable set for keys that are only queried after they were collected (see freeze()).
+The keys are stored in one contiguous array without any empty slots, their positions are given by a
+minimal perfect hash function (PTHash scheme):
+* every key belongs to one of about size / KEYS_PER_BUCKET buckets (high bits of its hash value)
+* every bucket has a pilot (16 bits) that was searched for while building: position = mix(hash ^ mix(pilot)) % table_size,
+  the pilot is chosen so that none of the keys of the bucket collides with a key that was placed before
+  (the biggest buckets are placed first, while most positions are still free)
+* table_size is a little larger than size so that the last buckets find free positions quickly,
+  the few keys placed at or behind size are moved into the holes in front of it (free_slots)
+count() reads the pilot of the bucket and compares one key: two memory accesses, three for the keys in free_slots.
+Memory: the keys plus about 4 bits (pilots) and 1.3 bits (free_slots) per key.
+-----------------
+*/
+template <typename Key, typename Hash = ADS_hash<Key>, typename KeyEqual = std::equal_to<>>
+class ADS_frozen_set
+{
+public:
+    using value_type = Key;
+    using key_type = Key;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = const key_type *; // the keys are one contiguous array
+    using iterator = const_iterator;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+
+private:
+    using pilot_t = uint16_t;
+
+    static constexpr size_type KEYS_PER_BUCKET{4};
+    static constexpr double LOAD_FACTOR{0.98};  // size / table_size
+    static constexpr uint32_t MAX_PILOT{0xFFFF}; // a bucket without a pilot below this fails the seed
+    static constexpr unsigned MAX_SEEDS{32};     // seeds that are tried before giving up
+
+    std::vector<key_type> keys;        // keys[position of the key]
+    std::vector<pilot_t> pilots;       // one pilot per bucket
+    std::vector<size_type> free_slots; // free_slots[position - size()]: the real position of a key placed at or behind size()
+    size_type table_size{0};           // positions the pilots spread the keys over
+    uint64_t seed{0};                  // mixed into every hash value, changed if no pilots were found with the previous one
+
+    /* hash value of key for the current seed, the bits are mixed unless the hasher is avalanching */
+    uint64_t hashOf(const key_type &key) const
+    {
+        uint64_t hash_value{hasher{}(key)};
+        if constexpr (!ADS_is_avalanching<hasher>::value)
+        {
+            hash_value = ADS_mix(hash_value);
+        }
+        return ADS_mix(hash_value ^ seed);
+    }
+
+    size_type bucketOf(uint64_t hash_value) const
+    {
+        return size_type(((hash_value >> 32) * pilots.size()) >> 32);
+    }
+
+    size_type positionOf(uint64_t hash_value, pilot_t pilot) const
+    {
+        return size_type(ADS_mix(hash_value ^ ADS_mix(pilot)) % table_size);
+    }
+
+    /*
+    Searches a pilot for every bucket with the current seed, positions[i] is set to the position of the key with hashes[i].
+    Return value: false if a bucket has no pilot below MAX_PILOT (keys with equal hash values never get one)
+    */
+    bool placeKeys(const std::vector<uint64_t> &hashes, std::vector<size_type> &positions);
+
+public:
+    /* ------- CONSTRUCTORS ------- */
+
+    ADS_frozen_set() = default;
+
+    /*
+    Builds the set from the distinct keys in [first, last[. Complexity: O(range_size) expected
+    Throws std::invalid_argument if no perfect hash function is found (a key occurs twice, or two keys have the same hash value).
+    */
+    template <typename ForwardIt>
+    ADS_frozen_set(ForwardIt first, ForwardIt last);
+
+    /* ------- PUBLIC METHODS ------- */
+
+    size_type size() const
+    {
+        return keys.size();
+    }
+
+    bool empty() const
+    {
+        return keys.empty();
+    }
+
+    /*
+    Return value: pointer to the stored key, or end() if key is not stored
+    */
+    const_iterator find(const key_type &key) const
+    {
+        if (keys.empty())
+        {
+            return end();
+        }
+        uint64_t hash_value{hashOf(key)};
+        size_type position{positionOf(hash_value, pilots[bucketOf(hash_value)])};
+        if (position >= keys.size())
+        {
+            position = free_slots[position - keys.size()];
+        }
+        return key_equal{}(keys[position], key) ? keys.data() + position : end();
+    }
+
+    size_type count(const key_type &key) const
+    {
+        return find(key) != end();
+    }
+
+    const_iterator begin() const
+    {
+        return keys.data();
+    }
+
+    const_iterator end() const
+    {
+        return keys.data() + keys.size();
+    }
+
+    void swap(ADS_frozen_set &other)
+    {
+        keys.swap(other.keys);
+        pilots.swap(other.pilots);
+        free_slots.swap(other.free_slots);
+        std::swap(table_size, other.table_size);
+        std::swap(seed, other.seed);
+    }
+
+    /*
+    Output the pilots and the keys to the stream o
+    */
+    void dump(std::ostream &o = std::cerr) const;
+
+    /* ------- OPERATORS ------- */
+
+    friend bool operator==(const ADS_frozen_set &lhs, const ADS_frozen_set &rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return false;
+        }
+        for (const auto &key : lhs)
+        {
+            if (!rhs.count(key))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const ADS_frozen_set &lhs, const ADS_frozen_set &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+/* ------- FROZEN SET IMPLEMENTATION ------- */
+template <typename Key, typename Hash, typename KeyEqual>
+template <typename ForwardIt>
+ADS_frozen_set<Key, Hash, KeyEqual>::ADS_frozen_set(ForwardIt first, ForwardIt last)
+{
+    std::vector<const key_type *> sources;
+    sources.reserve(size_type(std::distance(first, last)));
+    for (auto it{first}; it != last; ++it)
+    {
+        sources.push_back(&*it);
+    }
+    if (sources.empty())
+    {
+        return;
+    }
+
+    std::vector<uint64_t> hashes(sources.size());
+    std::vector<size_type> positions(sources.size());
+    for (unsigned attempt{0};; ++attempt)
+    {
+        if (attempt == MAX_SEEDS)
+        {
+            throw std::invalid_argument("ADS_frozen_set: the keys are not distinct or their hash values collide");
+        }
+        seed = ADS_mix(attempt + 1);
+        for (size_type index{0}; index < sources.size(); ++index)
+        {
+            hashes[index] = hashOf(*sources[index]);
+        }
+        if (placeKeys(hashes, positions))
+        {
+            break;
+        }
+    }
+
+    // the keys are copied in the order of their positions
+    std::vector<size_type> order(sources.size());
+    for (size_type index{0}; index < sources.size(); ++index)
+    {
+        order[positions[index]] = index;
+    }
+    keys.reserve(sources.size());
+    for (size_type index : order)
+    {
+        keys.push_back(*sources[index]);
+    }
+}
+
+template <typename Key, typename Hash, typename KeyEqual>
+bool ADS_frozen_set<Key, Hash, KeyEqual>::placeKeys(const std::vector<uint64_t> &hashes, std::vector<size_type> &positions)
+{
+    const size_type key_count{hashes.size()};
+    pilots.assign((key_count + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET, 0);
+    table_size = std::max(key_count, size_type(double(key_count) / LOAD_FACTOR));
+
+    // keys grouped by bucket (counting sort), buckets ordered by size, biggest first
+    std::vector<size_type> bucket_start(pilots.size() + 1);
+    for (uint64_t hash_value : hashes)
+    {
+        ++bucket_start[bucketOf(hash_value) + 1];
+    }
+    std::partial_sum(bucket_start.begin(), bucket_start.end(), bucket_start.begin());
+    std::vector<size_type> bucket_keys(key_count);
+    {
+        std::vector<size_type> next{bucket_start.begin(), bucket_start.end() - 1};
+        for (size_type index{0}; index < key_count; ++index)
+        {
+            bucket_keys[next[bucketOf(hashes[index])]++] = index;
+        }
+    }
+    std::vector<size_type> buckets(pilots.size());
+    std::iota(buckets.begin(), buckets.end(), size_type{0});
+    std::stable_sort(buckets.begin(), buckets.end(), [&bucket_start](size_type lhs, size_type rhs)
+                     { return bucket_start[lhs + 1] - bucket_start[lhs] > bucket_start[rhs + 1] - bucket_start[rhs]; });
+
+    std::vector<bool> taken(table_size);
+    for (size_type bucket : buckets)
+    {
+        const size_type first{bucket_start[bucket]};
+        const size_type last{bucket_start[bucket + 1]};
+        if (first == last)
+        {
+            break; // all remaining buckets are empty
+        }
+        uint32_t pilot{0};
+        for (; pilot <= MAX_PILOT; ++pilot)
+        {
+            size_type placed{first};
+            for (; placed < last; ++placed)
+            {
+                size_type position{positionOf(hashes[bucket_keys[placed]], pilot_t(pilot))};
+                if (taken[position])
+                {
+                    break;
+                }
+                taken[position] = true; // a later key of the same bucket must not get the same position
+                positions[bucket_keys[placed]] = position;
+            }
+            if (placed == last)
+            {
+                break;
+            }
+            while (placed-- > first) // collision: the positions of this attempt are given back
+            {
+                taken[positions[bucket_keys[placed]]] = false;
+            }
+        }
+        if (pilot > MAX_PILOT)
+        {
+            return false;
+        }
+        pilots[bucket] = pilot_t(pilot);
+    }
+
+    // positions at or behind key_count are moved into the free positions in front of it
+    free_slots.assign(table_size - key_count, 0);
+    size_type hole{0};
+    for (size_type position{key_count}; position < table_size; ++position)
+    {
+        if (!taken[position])
+        {
+            continue;
+        }
+        while (taken[hole])
+        {
+            ++hole;
+        }
+        free_slots[position - key_count] = hole++;
+    }
+    for (size_type &position : positions)
+    {
+        if (position >= key_count)
+        {
+            position = free_slots[position - key_count];
+        }
+    }
+    return true;
+}
+
+template <typename Key, typename Hash, typename KeyEqual>
+void ADS_frozen_set<Key, Hash, KeyEqual>::dump(std::ostream &o) const
+{
+    o << "size = " << keys.size() << ", table_size = " << table_size << ", buckets = " << pilots.size() << "\n";
+    o << "pilots:";
+    for (pilot_t pilot : pilots)
+    {
+        o << " " << pilot;
+    }
+    o << "\n";
+    for (size_type position{0}; position < keys.size(); ++position)
+    {
+        o << position << ": [" << keys[position] << "]\n";
+    }
+    o << "\n";
+}
+
+/*
+Return value: an immutable copy of set whose count() needs no chain walk and no probing (see ADS_frozen_set)
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_frozen_set<Key, Hash, KeyEqual> freeze(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &set)
+{
+    return ADS_frozen_set<Key, Hash, KeyEqual>(set.begin(), set.end());
+}
+
+#endif // ADS_FROZEN_SET_H
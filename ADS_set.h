@@ -6,524 +6,4069 @@
 #include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <exception>
+#include <atomic>
+#include <chrono>
 
+#if !defined(ADS_SET_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define ADS_SET_SSE2
+#endif
+
+/*
+Hint to the CPU to load address into the cache (no effect if the compiler does not support it)
+*/
+inline void ADS_prefetch(const void *address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(ADS_SET_SSE2)
+    _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+/*
+-----------------
+SEPARATE CHAINING
+-----------------
+author: Hynek Zemanec
+-----------------
+Conventions:
+* snake_case for member variables
+* camelCase for everything else
+-----------------
+Specs: https://cewebs.cs.univie.ac.at/algodat/ss22/index.php?m=D&t=info&c=show&CEWebS_what=Spezifikation
+*/
+
+/*
+Mixes the bits of a hash value, every bit of the result depends on every bit of hash_value.
+Multiplies with 2^64 / golden ratio and folds the upper half of the 128 bit product onto the lower half
+(murmur3 finalizer if there is no 128 bit multiplication).
+*/
+inline size_t ADS_mix(uint64_t hash_value)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ using uint128_t = unsigned __int128;
+    uint128_t product{uint128_t(hash_value) * 0x9e3779b97f4a7c15ULL};
+    return size_t(uint64_t(product) ^ uint64_t(product >> 64));
+#else
+    hash_value ^= hash_value >> 33;
+    hash_value *= 0xff51afd7ed558ccdULL;
+    hash_value ^= hash_value >> 33;
+    hash_value *= 0xc4ceb9fe1a85ec53ULL;
+    hash_value ^= hash_value >> 33;
+    return size_t(hash_value);
+#endif
+}
+
+/*
+true if Hash declares is_avalanching: all bits of its hash values are equally good, the low bits can be used directly
+*/
+template <typename Hash, typename = void>
+struct ADS_is_avalanching : std::false_type
+{
+};
+
+template <typename Hash>
+struct ADS_is_avalanching<Hash, std::void_t<typename Hash::is_avalanching>> : std::true_type
+{
+};
+
+/*
+Default hasher of ADS_set: std::hash of the key mixed with ADS_mix
+(std::hash is the identity for integers, so structured keys would only differ in a few bits)
+*/
+template <typename Key>
+struct ADS_hash
+{
+    using is_avalanching = void;
+
+    size_t operator()(const Key &key) const
+    {
+        return ADS_mix(std::hash<Key>{}(key));
+    }
+};
+
+/*
+Strings are hashed as std::basic_string_view (std::hash gives a string and its view the same value).
+The hasher is transparent, so a set of strings can be searched with a string_view or a string literal
+without creating a temporary string.
+*/
+template <typename CharT, typename Alloc>
+struct ADS_hash<std::basic_string<CharT, std::char_traits<CharT>, Alloc>>
+{
+    using is_transparent = void;
+    using is_avalanching = void;
+
+    size_t operator()(std::basic_string_view<CharT> key) const
+    {
+        return ADS_mix(std::hash<std::basic_string_view<CharT>>{}(key));
+    }
+};
+
+/*
+true if Hash and KeyEqual both declare is_transparent, i.e. they accept other types than the key type (K is only there
+to make the check depend on the argument of a heterogeneous lookup)
+*/
+template <typename Hash, typename KeyEqual, typename K, typename = void>
+struct ADS_is_transparent : std::false_type
+{
+};
+
+template <typename Hash, typename KeyEqual, typename K>
+struct ADS_is_transparent<Hash, KeyEqual, K, std::void_t<typename Hash::is_transparent, typename KeyEqual::is_transparent>>
+    : std::true_type
+{
+};
+
+/*
+Decides if the full hash value of a key is stored in its Element next to the key.
+Caching pays off for keys that are expensive to hash or compare (strings, user types): rehash() then never calls the hasher
+and a lookup only compares keys whose hash values are equal.
+For arithmetic, enum and pointer keys the hash is (almost) free, so the extra memory per element is not spent.
+Can be specialized for user types. Small keys that should not live in nodes at all are best stored with ADS_flat_set.
+*/
+template <typename Key>
+struct ADS_cache_hash
+    : std::integral_constant<bool, !(std::is_arithmetic<Key>::value || std::is_enum<Key>::value || std::is_pointer<Key>::value)>
+{
+};
+
+/*
+Base of an Element that holds the cached hash value of the key (see ADS_cache_hash)
+*/
+template <bool CACHED>
+struct ADS_element_hash
+{
+    size_t hash_value;
+    ADS_element_hash(size_t hash_value) : hash_value{hash_value} {}
+};
+
+/*
+Nothing is cached, the hash value passed on construction is dropped
+*/
+template <>
+struct ADS_element_hash<false>
+{
+    ADS_element_hash(size_t) {}
+};
+
+/*
+Bucket occupancy bitmap of the separate chaining engine: bit i of the bitmap is set if bucket i holds a chain.
+Iteration finds the next non-empty bucket by looking at 64 buckets at once (count trailing zeros),
+so a sparse table is not walked pointer by pointer.
+*/
+struct ADS_bitmap
+{
+    using word_t = uint64_t;
+    static constexpr size_t WORD_BITS{64};
+
+    /* number of words for bits bits */
+    static size_t words(size_t bits)
+    {
+        return (bits + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    static void set(word_t *bitmap, size_t index)
+    {
+        bitmap[index / WORD_BITS] |= word_t(1) << (index % WORD_BITS);
+    }
+
+    static void reset(word_t *bitmap, size_t index)
+    {
+        bitmap[index / WORD_BITS] &= ~(word_t(1) << (index % WORD_BITS));
+    }
+
+    /* index of the lowest set bit, word must not be 0 */
+    static size_t lowestBit(word_t word)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return size_t(__builtin_ctzll(word));
+#else
+        size_t index{0};
+        while (!(word & 1))
+        {
+            word >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
+
+    /* first set bit at or after from, bits if there is none */
+    static size_t next(const word_t *bitmap, size_t from, size_t bits)
+    {
+        if (from >= bits)
+        {
+            return bits;
+        }
+        size_t word_index{from / WORD_BITS};
+        word_t word{bitmap[word_index] & (~word_t(0) << (from % WORD_BITS))};
+        const size_t word_count{words(bits)};
+        while (!word)
+        {
+            if (++word_index == word_count)
+            {
+                return bits;
+            }
+            word = bitmap[word_index];
+        }
+        return std::min(bits, word_index * WORD_BITS + lowestBit(word));
+    }
+};
+
+/*
+Calls function(part) for part = 0 ... parts - 1, every call on its own thread, and waits for all of them.
+The first exception of a call (or of starting a thread) is passed on after all threads have finished.
+*/
+template <typename Function>
+void ADS_parallel(unsigned parts, Function function)
+{
+    std::vector<std::exception_ptr> errors(parts);
+    std::vector<std::thread> workers;
+    workers.reserve(parts);
+    try
+    {
+        for (unsigned part{0}; part < parts; ++part)
+        {
+            workers.emplace_back([&errors, &function, part]
+                                 {
+                                     try
+                                     {
+                                         function(part);
+                                     }
+                                     catch (...)
+                                     {
+                                         errors[part] = std::current_exception();
+                                     }
+                                 });
+        }
+    }
+    catch (...)
+    {
+        // a thread could not be started, the running ones are finished before the exception is passed on
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        throw;
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    for (const std::exception_ptr &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/*
+Blocked counting Bloom filter of hash values, the negative filter of ADS_set (see ADS_set::negative_filter()).
+A hash value selects one block of 64 bytes (one cache line) and PROBES of its 128 counters (4 bits each):
+add() increments them, remove() decrements them, and mayContain() is false if one of them is 0, so a lookup of a
+missing key is answered with a single cache miss most of the time. Counters that reached 15 stay at 15 (they no longer
+know how many keys they count), which only raises the false positive rate, never hides a stored key.
+The filter is sized for COUNTERS_PER_KEY counters per key (about 1% false positives) but never exceeds MAX_BYTES,
+so it stays in L2; beyond MAX_BYTES * 2 / COUNTERS_PER_KEY keys the false positive rate grows (see falsePositiveRate()).
+*/
+class ADS_counting_filter
+{
+public:
+    static constexpr size_t MAX_BYTES{512 * 1024};
+
+private:
+    static constexpr size_t BLOCK_COUNTERS{128};
+    static constexpr size_t COUNTERS_PER_KEY{12};
+    static constexpr unsigned PROBES{4};
+    static constexpr uint64_t MAX_COUNT{15};
+
+    struct alignas(64) Block
+    {
+        uint64_t words[8]; // 16 counters per word
+    };
+
+    std::vector<Block> blocks; // empty: the filter is off and mayContain() is always true
+    size_t capacity{0};        // keys the filter was sized for
+
+    /* block of a mixed hash value (high 32 bits), its counters are taken from the low 28 bits (7 bits per probe) */
+    size_t blockOf(uint64_t mixed) const
+    {
+        return size_t(((mixed >> 32) * blocks.size()) >> 32);
+    }
+
+    static unsigned shiftOf(uint64_t mixed, unsigned probe)
+    {
+        return unsigned((mixed >> (7 * probe)) & 15) * 4;
+    }
+
+    static size_t wordOf(uint64_t mixed, unsigned probe)
+    {
+        return size_t((mixed >> (7 * probe + 4)) & 7);
+    }
+
+public:
+    bool enabled() const
+    {
+        return !blocks.empty();
+    }
+
+    /* memory held by the counters */
+    size_t bytes() const
+    {
+        return blocks.size() * sizeof(Block);
+    }
+
+    /* true if the filter would be bigger if it was sized for keys (it is rebuilt then, see ADS_set::rehash()) */
+    bool tooSmallFor(size_t keys) const
+    {
+        return keys > capacity && bytes() < MAX_BYTES;
+    }
+
+    /* turns the filter on with all counters 0, sized for keys */
+    void resize(size_t keys)
+    {
+        const size_t block_count{std::min(MAX_BYTES / sizeof(Block),
+                                           std::max(size_t{1}, (keys * COUNTERS_PER_KEY + BLOCK_COUNTERS - 1) / BLOCK_COUNTERS))};
+        blocks.assign(block_count, Block{});
+        capacity = keys;
+    }
+
+    /* sets all counters to 0, the size is kept */
+    void clear()
+    {
+        std::fill(blocks.begin(), blocks.end(), Block{});
+    }
+
+    /* turns the filter off and frees the counters */
+    void reset()
+    {
+        std::vector<Block>().swap(blocks);
+        capacity = 0;
+    }
+
+    /* add() and remove() do nothing if the filter is off */
+    void add(uint64_t hash_value)
+    {
+        if (blocks.empty())
+        {
+            return;
+        }
+        const uint64_t mixed{ADS_mix(hash_value)};
+        Block &block{blocks[blockOf(mixed)]};
+        for (unsigned probe{0}; probe < PROBES; ++probe)
+        {
+            uint64_t &word{block.words[wordOf(mixed, probe)]};
+            const unsigned shift{shiftOf(mixed, probe)};
+            if (((word >> shift) & MAX_COUNT) != MAX_COUNT)
+            {
+                word += uint64_t{1} << shift;
+            }
+        }
+    }
+
+    /* hash_value must have been added before */
+    void remove(uint64_t hash_value)
+    {
+        if (blocks.empty())
+        {
+            return;
+        }
+        const uint64_t mixed{ADS_mix(hash_value)};
+        Block &block{blocks[blockOf(mixed)]};
+        for (unsigned probe{0}; probe < PROBES; ++probe)
+        {
+            uint64_t &word{block.words[wordOf(mixed, probe)]};
+            const unsigned shift{shiftOf(mixed, probe)};
+            const uint64_t count{(word >> shift) & MAX_COUNT};
+            if (count != MAX_COUNT && count != 0)
+            {
+                word -= uint64_t{1} << shift;
+            }
+        }
+    }
+
+    /* false: no key with hash_value was added. Always true if the filter is off. */
+    bool mayContain(uint64_t hash_value) const
+    {
+        if (blocks.empty())
+        {
+            return true;
+        }
+        const uint64_t mixed{ADS_mix(hash_value)};
+        const Block &block{blocks[blockOf(mixed)]};
+        bool found{true};
+        for (unsigned probe{0}; probe < PROBES; ++probe)
+        {
+            found &= ((block.words[wordOf(mixed, probe)] >> shiftOf(mixed, probe)) & MAX_COUNT) != 0;
+        }
+        return found;
+    }
+
+    /*
+    Expected share of missing keys that pass mayContain(): the average over all blocks of
+    (non-zero counters of the block / BLOCK_COUNTERS) ^ PROBES. Complexity: O(bytes())
+    */
+    double falsePositiveRate() const
+    {
+        double sum{0};
+        for (const Block &block : blocks)
+        {
+            size_t used{0};
+            for (uint64_t word : block.words)
+            {
+                for (unsigned shift{0}; shift < 64; shift += 4)
+                {
+                    used += ((word >> shift) & MAX_COUNT) != 0;
+                }
+            }
+            double rate{1};
+            for (unsigned probe{0}; probe < PROBES; ++probe)
+            {
+                rate *= double(used) / double(BLOCK_COUNTERS);
+            }
+            sum += rate;
+        }
+        return blocks.empty() ? 0 : sum / double(blocks.size());
+    }
+
+    void swap(ADS_counting_filter &other)
+    {
+        blocks.swap(other.blocks);
+        std::swap(capacity, other.capacity);
+    }
+};
+
+/*
+Statistics of an ADS_set, returned by stats() and printed by dump(o, ADS_dump::summary).
+The values describing the table are computed when stats() is called. The event counters (rehashes, rehash_time, lookups, probes,
+filtered_lookups, filter_false_positives) are only collected if ADS_SET_STATS is defined before this file is included (see ADS_set_counters), otherwise they stay 0.
+*/
+struct ADS_set_stats
+{
+    size_t size{0};                       // stored keys
+    size_t bucket_count{0};               // buckets (separate chaining, both tables during a migration) or slots (open addressing)
+    double load_factor{0};                // size / bucket_count
+    double empty_bucket_ratio{0};         // empty buckets (slots) / bucket_count
+    size_t max_chain{0};                  // longest chain, or longest probe sequence in groups (open addressing)
+    std::vector<size_t> chain_lengths;    // chain_lengths[l]: buckets with a chain of l keys, or keys found in the l-th group they probe (open addressing)
+    size_t bytes{0};                      // memory held by the table(s), the bitmaps, the nodes and the negative filter
+    uint64_t rehashes{0};                 // tables built by growing, shrinking and rehash()
+    std::chrono::nanoseconds rehash_time{0};
+    uint64_t lookups{0};                  // locates by find(), count(), insert() and erase() that looked at the table
+    uint64_t probes{0};                   // nodes (separate chaining) or groups (open addressing) looked at by these lookups
+    size_t filter_bytes{0};               // memory held by the negative filter, 0 if it is off (see ADS_set::negative_filter())
+    double filter_false_positive_rate{0}; // expected share of missing keys that pass the negative filter (see ADS_counting_filter)
+    uint64_t filtered_lookups{0};         // lookups answered by the negative filter without looking at the table
+    uint64_t filter_false_positives{0};   // lookups that passed the negative filter but did not find their key
+
+    double probes_per_lookup() const
+    {
+        return lookups ? double(probes) / double(lookups) : 0;
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &o, const ADS_set_stats &stats)
+{
+    o << "size = " << stats.size << ", buckets = " << stats.bucket_count << ", load_factor = " << stats.load_factor
+      << ", empty_buckets = " << stats.empty_bucket_ratio << ", max_chain = " << stats.max_chain << ", bytes = " << stats.bytes << "\n";
+    o << "chain lengths:";
+    for (size_t length{0}; length < stats.chain_lengths.size(); ++length)
+    {
+        if (stats.chain_lengths[length])
+        {
+            o << " " << length << ": " << stats.chain_lengths[length];
+        }
+    }
+    o << "\n";
+    o << "rehashes = " << stats.rehashes << " (" << stats.rehash_time.count() / 1000 << " us), lookups = " << stats.lookups
+      << ", probes per lookup = " << stats.probes_per_lookup() << "\n";
+    if (stats.filter_bytes)
+    {
+        o << "negative filter: bytes = " << stats.filter_bytes << ", false positive rate = " << stats.filter_false_positive_rate
+          << ", filtered lookups = " << stats.filtered_lookups << ", false positives = " << stats.filter_false_positives << "\n";
+    }
+    return o;
+}
+
+/*
+Event counters of an ADS_set (see ADS_set_stats). Unless ADS_SET_STATS is defined every method is empty,
+so the counting calls in the hot paths compile to nothing.
+Lookups on a const set are counted as well and may run in parallel (readers of an ADS_concurrent_set shard),
+so the counters are atomics that are only updated with relaxed ordering.
+*/
+#ifdef ADS_SET_STATS
+class ADS_set_counters
+{
+private:
+    std::atomic<uint64_t> rehashes{0};
+    std::atomic<uint64_t> rehash_nanoseconds{0};
+    mutable std::atomic<uint64_t> lookups{0};
+    mutable std::atomic<uint64_t> probes{0};
+    mutable std::atomic<uint64_t> filtered{0};
+    mutable std::atomic<uint64_t> false_positives{0};
+
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    /* one lookup that looked at probes nodes or groups */
+    void countLookup(uint64_t probe_count) const
+    {
+        lookups.fetch_add(1, std::memory_order_relaxed);
+        probes.fetch_add(probe_count, std::memory_order_relaxed);
+    }
+
+    /* one lookup answered by the negative filter */
+    void countFiltered() const
+    {
+        filtered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* one lookup that passed the negative filter and did not find its key */
+    void countFalsePositive() const
+    {
+        false_positives.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void countRehash()
+    {
+        rehashes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static time_point startTimer()
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    /* adds the time since start to the rehash time */
+    void stopTimer(time_point start)
+    {
+        auto elapsed{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)};
+        rehash_nanoseconds.fetch_add(uint64_t(elapsed.count()), std::memory_order_relaxed);
+    }
+
+    void fill(ADS_set_stats &stats) const
+    {
+        stats.rehashes = rehashes.load(std::memory_order_relaxed);
+        stats.rehash_time = std::chrono::nanoseconds(rehash_nanoseconds.load(std::memory_order_relaxed));
+        stats.lookups = lookups.load(std::memory_order_relaxed);
+        stats.probes = probes.load(std::memory_order_relaxed);
+        stats.filtered_lookups = filtered.load(std::memory_order_relaxed);
+        stats.filter_false_positives = false_positives.load(std::memory_order_relaxed);
+    }
+
+    /* not atomic as a whole, like the swap of the containers */
+    void swap(ADS_set_counters &other)
+    {
+        rehashes.store(other.rehashes.exchange(rehashes.load()));
+        rehash_nanoseconds.store(other.rehash_nanoseconds.exchange(rehash_nanoseconds.load()));
+        lookups.store(other.lookups.exchange(lookups.load()));
+        probes.store(other.probes.exchange(probes.load()));
+        filtered.store(other.filtered.exchange(filtered.load()));
+        false_positives.store(other.false_positives.exchange(false_positives.load()));
+    }
+};
+#else
+class ADS_set_counters
+{
+public:
+    struct time_point
+    {
+    };
+
+    void countLookup(uint64_t) const {}
+    void countFiltered() const {}
+    void countFalsePositive() const {}
+    void countRehash() {}
+    static time_point startTimer() { return {}; }
+    void stopTimer(time_point) {}
+    void fill(ADS_set_stats &) const {}
+    void swap(ADS_set_counters &) {}
+};
+#endif
+
+/*
+What dump() prints: every bucket with its keys (full), or only the statistics (summary, see ADS_set_stats)
+*/
+enum class ADS_dump
+{
+    full,
+    summary
+};
+
+/*
+Set operations on ADS_sets (set_union(), set_intersection(), ...), see the end of this file
+*/
+struct ADS_set_algebra;
+
+/*
+Storage engines of ADS_set (last template parameter):
+* ADS_chaining: separate chaining, every bucket holds a linked list of Element nodes (default)
+* ADS_open_addressing: flat table, the keys are stored directly in one contiguous slot array (see ADS_flat_set)
+*/
+struct ADS_chaining
+{
+};
+
+struct ADS_open_addressing
+{
+};
+
+/* ADS_set is a container for elements (a simplification "std::set" and "std::unordered_set")
+Elements are identified by a key. (the entire stored element serves as the key)
+
+insertion of existing values is ignored
+N: the initial size of the hash table
+Hash: hasher (default constructible), if it declares is_avalanching the table size is a power of two (see ADS_hash)
+KeyEqual: compares two keys (default constructible)
+Allocator: allocator the Element nodes are taken from (rebound to Element, slabs are requested from it)
+Storage: storage engine, ADS_chaining or ADS_open_addressing */
+template <typename Key, size_t N = 7, typename Hash = ADS_hash<Key>, typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<Key>, typename Storage = ADS_chaining>
+class ADS_set
+{
+
+public:
+    class Iterator;
+    using value_type = Key; // Key is the type of the key
+    using key_type = Key;   // Key is the type of the element
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t; // the size of something (positive ints)
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = Iterator;
+    using iterator = const_iterator;
+    using key_equal = KeyEqual; // compares keys (std::equal_to<> is transparent, see heterogeneous lookup)
+    using hasher = Hash;        // struct that can hash any data type
+    using allocator_type = Allocator;
+
+private:
+    static constexpr bool cache_hash{ADS_cache_hash<key_type>::value};
+
+    /*
+    The hash value of an avalanching hasher is equally good in all bits, so the bucket is taken from the low bits
+    with a mask and the table size is always a power of two. Otherwise the bucket is hash % table_size.
+    */
+    static constexpr bool power_of_two{ADS_is_avalanching<hasher>::value};
+
+    /* table size used for at least n buckets */
+    static constexpr size_type tableSizeFor(size_type n)
+    {
+        if (!power_of_two)
+        {
+            return n ? n : 1;
+        }
+        size_type size{1};
+        while (size < n)
+        {
+            size *= 2;
+        }
+        return size;
+    }
+
+    static constexpr size_type INITIAL_TABLE_SIZE{tableSizeFor(N)};
+
+    /* bucket of a full hash value in a table with size buckets */
+    static size_type bucketIndex(size_type full_hash, size_type size)
+    {
+        if constexpr (power_of_two)
+        {
+            return full_hash & (size - 1);
+        }
+        else
+        {
+            return full_hash % size;
+        }
+    }
+
+    /*
+    Heterogeneous lookup: count(), find() and erase() accept any type K that hasher and key_equal accept,
+    if both declare is_transparent (e.g. std::string_view for std::string keys)
+    */
+    template <typename K>
+    using enable_if_transparent = std::enable_if_t<ADS_is_transparent<hasher, key_equal, K>::value>;
+
+    /*
+    nextPtr: pointer to the adjecent element (that hashed to the same index)
+    hash_value (inherited, only if cache_hash): full hash value of the key, so the element can be moved to another bucket without hashing the key again
+    */
+    struct Element : ADS_element_hash<cache_hash>
+    {
+        key_type key;
+        Element *nextPtr{nullptr};
+    };
+
+    /*
+    Slab allocator for Element nodes: hands out nodes carved from larger slabs and recycles erased nodes through a free list
+    */
+    class ElementPool;
+
+    Element **table{nullptr};       // pointer to the array of pointers
+    size_type table_size{0};        // how much room there is
+    size_type inserted_elements{0}; // how many elements have been inserted
+    float max_load_factor{0.7};     // recommended inserted_elements/table_size
+    float min_load_factor{0};       // erase() shrinks the table below this load factor, 0: never (see shrink_on_erase())
+    ElementPool element_pool;       // owns the memory of all Element nodes
+
+    /*
+    Occupancy of the buckets (see ADS_bitmap), one bitmap per table. first_occupied is the first non-empty bucket as used
+    by Iterator (table_size + old_table_size if the container is empty), so begin() does not have to search for it.
+    */
+    ADS_bitmap::word_t *occupancy{nullptr};
+    ADS_bitmap::word_t *old_occupancy{nullptr};
+    size_type first_occupied{0};
+
+    /*
+    Table of a container that has not allocated one yet (new, moved from, cleared): one empty bucket shared by all such
+    containers, so lookups and iterators need no extra check. It is only read; the first insert() (reserve()) replaces it.
+    */
+    static inline Element *empty_table[1]{};
+    static inline ADS_bitmap::word_t empty_occupancy[1]{};
+
+    bool ownsTable() const
+    {
+        return table != empty_table;
+    }
+
+    /*
+    Order independent summary of the contents: the sum of the mixed hash values of all keys (see fingerprintOf()).
+    Updated by every insert and erase, so operator== rejects most unequal containers without looking at a single key.
+    */
+    size_type fingerprint{0};
+
+    /* rehashes and lookups, only counted if ADS_SET_STATS is defined (see stats()). A copy starts with its own counters. */
+    ADS_set_counters counters;
+
+    /*
+    Negative filter (see negative_filter()): holds the full hash values of all keys, off unless it was turned on.
+    locate() does not look at the table for keys it rejects.
+    */
+    ADS_counting_filter filter;
+
+    /* contribution of a key with the full hash value full_hash to fingerprint */
+    static size_type fingerprintOf(size_type full_hash)
+    {
+        return ADS_mix(full_hash);
+    }
+
+    /*
+    Incremental rehash: instead of moving all elements when the table grows, the old table is kept and
+    MIGRATION_STEP of its buckets are moved to the new table by every insert() and erase().
+    Lookups and iterators look at both tables until the old one is empty.
+    */
+    static constexpr size_type MIGRATION_STEP{8};
+    bool incremental_rehash_enabled{false}; // grow incrementally (see incremental_rehash())
+    Element **old_table{nullptr};           // table that is being migrated into table, nullptr if no migration is running
+    size_type old_table_size{0};            // how much room there is in old_table
+    size_type migrated_buckets{0};          // buckets of old_table below this index have been moved already
+
+    /*
+    Helper function used in insert() method to add element (key) to the table.
+    Returns pointer to the added element
+    */
+    Element *add(const key_type &key)
+    {
+        return add(key, hasher{}(key));
+    }
+
+    /*
+    same as add(key) for a key whose full hash value is already known (an rvalue key is moved into the element)
+    */
+    template <typename K>
+    Element *add(K &&key, size_type full_hash);
+
+    /*
+    Puts an element that is not linked yet at the head of its chain
+    */
+    void link(Element *elementPtr, size_type full_hash);
+
+    /*
+    Number of keys that are hashed and whose buckets are prefetched together by a bulk insert or a batched lookup
+    */
+    static constexpr size_type BULK_BATCH{16};
+
+    /*
+    Looks up the keys of [first, last[ in batches of BULK_BATCH and calls function(element, bucket) for every key in order
+    (element is nullptr if the key is not stored). The lookups of a batch walk their chains together, one node per round,
+    and every round prefetches the nodes the next round reads, so the cache misses of the batch overlap.
+    Stops early if function returns false.
+    */
+    template <typename ForwardIt, typename Function>
+    void locateBatch(ForwardIt first, ForwardIt last, Function function) const;
+
+    /*
+    Bulk insert of a range whose size is known: the table must already be large enough for all keys.
+    Keys are hashed once in batches of BULK_BATCH and their buckets are prefetched before the batch is inserted.
+    Duplicates are only checked for if check_duplicates is true.
+    */
+    template <typename ForwardIt>
+    void addRange(ForwardIt first, ForwardIt last, bool check_duplicates);
+
+    /* below this many keys per thread buildParallel() does not split the work */
+    static constexpr size_type MIN_KEYS_PER_THREAD{4096};
+
+    /*
+    Fills the empty container with the keys of [first, last[ using threads threads. The table is sized for all keys first,
+    then every thread owns a range of buckets (a whole number of occupancy words) and the keys are partitioned by their bucket:
+    1. every thread hashes a slice of the keys and counts how many of them fall into the bucket range of every thread
+    2. every thread writes the indices of its keys to the place of their range (the counts give the offsets)
+    3. every thread links the keys of its range into its buckets, skipping duplicates, with nodes of its own block
+    No locks are needed because no two threads touch the same bucket, occupancy word or node.
+    Needs two temporary arrays of range_size hash values and indices.
+    */
+    template <typename RandomIt>
+    void buildParallel(RandomIt first, RandomIt last, unsigned threads);
+
+    /*
+    checks if the position is occupied, finds and returns pointer to a searched element based on key_type
+    */
+    template <typename K>
+    Element *locate(const K &key) const
+    {
+        size_type bucket;
+        return locate(key, bucket);
+    }
+
+    /*
+    same as locate(key), bucket is set to the position of the element as used by Iterator
+    (buckets of old_table follow the buckets of table)
+    */
+    template <typename K>
+    Element *locate(const K &key, size_type &bucket) const
+    {
+        return locate(key, hasher{}(key), bucket);
+    }
+
+    /*
+    same as locate(key, bucket) for a key whose full hash value is already known
+    */
+    template <typename K>
+    Element *locate(const K &key, size_type full_hash, size_type &bucket) const;
+
+    /*
+    Removes the element key from the chain starting at head. Returns true if the key was found.
+    */
+    template <typename K>
+    bool eraseFromChain(Element *&head, const K &key, size_type full_hash);
+
+    /*
+    true if the element holds key. If hash values are cached, the keys are only compared when the hash values are equal,
+    so walking a chain of long strings mostly compares integers.
+    */
+    template <typename K>
+    static bool holds(const Element *elementPtr, const K &key, size_type full_hash)
+    {
+        if constexpr (cache_hash)
+        {
+            if (elementPtr->hash_value != full_hash)
+            {
+                return false;
+            }
+        }
+        return key_equal{}(elementPtr->key, key);
+    }
+
+    /*
+    Implementation of insert(const key_type &) and insert(key_type &&)
+    */
+    template <typename K>
+    std::pair<iterator, bool> insertKey(K &&key)
+    {
+        const size_type full_hash{hasher{}(key)};
+        return insertKey(std::forward<K>(key), full_hash);
+    }
+
+    /*
+    same as insertKey(key) for a key whose full hash value is already known
+    */
+    template <typename K>
+    std::pair<iterator, bool> insertKey(K &&key, size_type full_hash);
+
+    /*
+    Implementation of erase(), for key_type and heterogeneous keys
+    */
+    template <typename K>
+    size_type eraseKey(const K &key)
+    {
+        return eraseKey(key, hasher{}(key));
+    }
+
+    /*
+    same as eraseKey(key) for a key whose full hash value is already known
+    */
+    template <typename K>
+    size_type eraseKey(const K &key, size_type full_hash);
+
+    /*
+    Implementation of find(), for key_type and heterogeneous keys
+    */
+    template <typename K>
+    iterator findKey(const K &key) const
+    {
+        size_type bucket;
+        if (Element * element{locate(key, bucket)})
+        {
+            return iteratorAt(element, bucket);
+        }
+        return end();
+    }
+
+    /*
+    Bucket bucket of table got a chain
+    */
+    void markOccupied(size_type bucket)
+    {
+        ADS_bitmap::set(occupancy, bucket);
+        first_occupied = std::min(first_occupied, bucket);
+    }
+
+    /*
+    The chain of bucket (numbered as in locate()) became empty
+    */
+    void markEmpty(size_type bucket)
+    {
+        if (bucket < table_size)
+        {
+            ADS_bitmap::reset(occupancy, bucket);
+        }
+        else
+        {
+            ADS_bitmap::reset(old_occupancy, bucket - table_size);
+        }
+        if (bucket == first_occupied)
+        {
+            first_occupied = nextOccupied(bucket);
+        }
+    }
+
+    /*
+    First non-empty bucket at or after from, numbered as in locate(). table_size + old_table_size if there is none.
+    */
+    static size_type nextOccupied(size_type table_size, const ADS_bitmap::word_t *occupancy,
+                                  size_type old_table_size, const ADS_bitmap::word_t *old_occupancy, size_type from)
+    {
+        if (from < table_size)
+        {
+            from = ADS_bitmap::next(occupancy, from, table_size);
+            if (from < table_size)
+            {
+                return from;
+            }
+        }
+        return table_size + ADS_bitmap::next(old_occupancy, from - table_size, old_table_size);
+    }
+
+    size_type nextOccupied(size_type from) const
+    {
+        return nextOccupied(table_size, occupancy, old_table_size, old_occupancy, from);
+    }
+
+    /*
+    Destroys all elements in the given buckets (the memory is given back by element_pool)
+    */
+    void destroyChains(Element **buckets, size_type bucket_count);
+
+    /*
+    Relinks every element of the chain into its bucket of table
+    */
+    void moveChain(Element *currentElementPtr);
+
+    /*
+    Moves up to bucket_count buckets of old_table to table. Frees old_table once all buckets are moved.
+    */
+    void migrateBuckets(size_type bucket_count);
+
+    /*
+    Iterator positioned on elementPtr, which is stored in bucket (see locate())
+    */
+    iterator iteratorAt(Element *elementPtr, size_type bucket) const
+    {
+        return iterator{table, occupancy, elementPtr, bucket, table_size, old_table, old_occupancy, old_table_size};
+    }
+
+    /*
+    Hashing function
+    */
+    size_type hash(const key_type &key) const;
+
+    /*
+    Full (not yet reduced to table_size) hash value of an element that is already stored, taken from the element if it is cached
+    */
+    size_type elementHash(const Element *elementPtr) const;
+
+    /*
+    Copies the table of other (no migration running) into this empty container: same table size, same chains in the same order.
+    All nodes are taken from one block, no key is hashed and nodes with trivially copyable keys are copied with memcpy.
+    */
+    void cloneFrom(const ADS_set &other);
+
+    /*
+    Shrinks the table after an erase() that left fewer than min_load_factor * table_size elements (see shrink_on_erase())
+    */
+    void shrinkIfSparse();
+
+    /*
+    Sizes the negative filter for the current table (see negative_filter()) and adds the hash values of all keys to it
+    */
+    void rebuildFilter();
+
+    /*
+    operator== for two tables of the same size (no migration running): the occupancy bitmaps have to be equal
+    and every key has to be in the chain with the same index in other
+    */
+    bool sameBuckets(const ADS_set &other) const;
+
+    /*
+    Head of the chain of bucket, numbered as in locate()
+    */
+    Element *bucketAt(size_type bucket) const
+    {
+        return bucket < table_size ? table[bucket] : old_table[bucket - table_size];
+    }
+
+    /*
+    Number of buckets visitBuckets() can be called for (the ones of old_table included)
+    */
+    size_type bucketCount() const
+    {
+        return table_size + old_table_size;
+    }
+
+    /*
+    Calls function(key) for every element in the buckets [first, last[ (numbered as in locate()).
+    Lets the set operations split a container into bucket ranges that are worked on in parallel.
+    */
+    template <typename Function>
+    void visitBuckets(size_type first, size_type last, Function function) const
+    {
+        for (size_type index{nextOccupied(first)}; index < last; index = nextOccupied(index + 1))
+        {
+            for (const Element *elementPtr{bucketAt(index)}; elementPtr; elementPtr = elementPtr->nextPtr)
+            {
+                function(elementPtr->key);
+            }
+        }
+    }
+
+    /*
+    Adds a key that is known not to be stored yet, the table must already be large enough (see reserve())
+    */
+    void addUnique(const key_type &key)
+    {
+        add(key);
+    }
+
+    friend struct ADS_set_algebra;
+    template <typename, size_t, size_t>
+    friend class ADS_concurrent_set; // hashes every key once, for the shard and for the bucket
+
+public:
+    /* ------- CONSTRUCTORS ------- */
+
+    /*
+    Default constructor. Creates an empty container without allocating anything: the table (of at least N buckets) is
+    allocated by the first insert() or reserve(). Complexity: O(1)
+    */
+    ADS_set() noexcept : ADS_set(Allocator{}) {};
+
+    /*
+    Creates an empty container whose Element nodes are allocated through allocator
+    */
+    explicit ADS_set(const Allocator &allocator) noexcept
+        : table{empty_table}, table_size{1}, inserted_elements{0}, element_pool{allocator}, occupancy{empty_occupancy}, first_occupied{1} {};
+
+    /*
+    initializer list constructor: Creates a container containing the elements from ilist. The elements are inserted in the order specified in ilist.
+    */
+    ADS_set(std::initializer_list<key_type> ilist) : ADS_set{}
+    {
+        insert(ilist);
+    }
+
+    /*
+    Range constructor. Creates a container containing the elements from the range `[first, last]`. The elements are inserted in the given order (starting with first). e.g. first = 1, last = 5 => [1, 2, 3, 4, 5] Complexity: Hashing: O(range_size)
+    */
+    template <typename InputIt>
+    ADS_set(InputIt first, InputIt last) : ADS_set{}
+    {
+        insert(first, last);
+    }
+
+    /*
+    Parallel range constructor: like the range constructor, but the keys are hashed and linked by threads threads (see buildParallel()).
+    For large ranges of key_type (e.g. a vector), smaller ranges or threads <= 1 are inserted by the calling thread.
+    */
+    template <typename RandomIt>
+    ADS_set(RandomIt first, RandomIt last, unsigned threads) : ADS_set{}
+    {
+        buildParallel(first, last, threads);
+    }
+
+    /*
+    Move constructor. Takes over the table and the elements of other, other is left empty without a table. Complexity: O(1)
+    */
+    ADS_set(ADS_set &&other) noexcept : ADS_set(other.get_allocator())
+    {
+        swap(other);
+    }
+
+    /*
+    PH2: copy constructor. The copy gets the same table size and the same chains as other (see cloneFrom()).
+    If a migration of other is running, the keys are inserted one by one into a table without a migration instead.
+    */
+    ADS_set(const ADS_set &other)
+        : ADS_set(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
+    {
+        if (other.old_table)
+        {
+            negative_filter(other.filter.enabled());
+            reserve(other.inserted_elements);
+            for (const auto &key : other)
+            {
+                add(key);
+            }
+        }
+        else
+        {
+            cloneFrom(other);
+        }
+        incremental_rehash_enabled = other.incremental_rehash_enabled;
+        min_load_factor = other.min_load_factor;
+    };
+
+    /*
+    PH2: Destructor: The destructors of the stored elements are called and the used memory space is completely freed. Complexity: O(size)
+    */
+    ~ADS_set()
+    {
+        destroyChains(table, table_size);
+        if (ownsTable())
+        {
+            delete[] table;
+            delete[] occupancy;
+        }
+        if (old_table)
+        {
+            destroyChains(old_table, old_table_size);
+            delete[] old_table;
+            delete[] old_occupancy;
+        }
+    };
+
+    /* ------- PUBLIC METHODS ------- */
+    /*
+    Inserts the elements from ilist. The elements are inserted in the order specified in ilist. Complexity: O(ilist_size)
+    */
+    void insert(std::initializer_list<key_type> ilist)
+    {
+        if (!ilist.size())
+        {
+            return;
+        }
+        insert(ilist.begin(), ilist.end());
+    }
+
+    /*
+    PH2: Inserts key.
+    Return value: A std::pair consisting of an iterator and a bool.
+    iterator: points to the inserted element if an element was inserted, or to the existing element with the same key if no element was inserted.
+    bool: true if an element was inserted, false otherwise. hashing O(1)  */
+    std::pair<iterator, bool> insert(const key_type &key)
+    {
+        return insertKey(key);
+    }
+
+    /*
+    Inserts key, the key is moved into the container if it is not stored yet. Same return value as insert(const key_type &).
+    */
+    std::pair<iterator, bool> insert(key_type &&key)
+    {
+        return insertKey(std::move(key));
+    }
+
+    /*
+    Inserts a key constructed from args. The key is constructed directly inside a new element, if an equal key
+    is stored already the element is given back to the pool (no allocation happened for it).
+    Same return value as insert(const key_type &).
+    */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args);
+
+    /*
+     Return value: Number of inserted elements that are stored in the container.
+    */
+    size_type size() const
+    {
+        return inserted_elements;
+    }
+
+    /*
+    true if size()==0, false otherwise.
+    */
+    bool empty() const
+    {
+        return inserted_elements == 0;
+    }
+
+    /*
+    Return value: The number of elements in the container with key ( can be either 0 or 1). Complexity: hashing O(1)
+    */
+    size_type count(const key_type &key) const
+    {
+        if (locate(key))
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+    /*
+    Heterogeneous count(), see enable_if_transparent
+    */
+    template <typename K, typename = enable_if_transparent<K>>
+    size_type count(const K &key) const
+    {
+        return locate(key) ? 1 : 0;
+    }
+
+    /*
+    Batched count(): writes count(key) for every key of [first, last[ to out, in order.
+    Much faster than calling count() in a loop for keys that are not in the cache (see locateBatch()).
+    Return value: out behind the last written count
+    */
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt count_batch(ForwardIt first, ForwardIt last, OutputIt out) const
+    {
+        locateBatch(first, last, [&out](const Element *element, size_type)
+                    {
+                        *out++ = size_type(element != nullptr);
+                        return true;
+                    });
+        return out;
+    }
+
+    /*
+    Batched find(): writes find(key) for every key of [first, last[ to out, in order.
+    Return value: out behind the last written iterator
+    */
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) const
+    {
+        locateBatch(first, last, [this, &out](Element *element, size_type bucket)
+                    {
+                        *out++ = element ? iteratorAt(element, bucket) : end();
+                        return true;
+                    });
+        return out;
+    }
+
+    /*
+    Return value: true if every key of [first, last[ is stored. Stops after the batch with the first missing key.
+    */
+    template <typename ForwardIt>
+    bool contains_many(ForwardIt first, ForwardIt last) const
+    {
+        bool contained{true};
+        locateBatch(first, last, [&contained](const Element *element, size_type)
+                    { return contained = element != nullptr; });
+        return contained;
+    }
+
+    /*
+    Inserts the elements from the range [first, last[ in the given order (starting with first).
+    Internally uses add() method. Complexity: Hashing: O(range_size)
+    For forward iterators the table is enlarged only once for the whole range (for size() + range_size elements)
+    and every key is hashed only once.
+    */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last);
+
+    /*
+    Inserts the elements from the range [first, last[ without checking if they are already stored.
+    The caller guarantees that the range contains no duplicates and no key that is already in the container,
+    otherwise the container holds the key twice. Complexity: O(range_size)
+    */
+    template <typename ForwardIt>
+    void insert_unique_unchecked(ForwardIt first, ForwardIt last)
+    {
+        reserve(inserted_elements + size_type(std::distance(first, last)));
+        addRange(first, last, false);
+    }
+
+    /*
+    PH2: Removes all elements from the container. Complexity: O(size)
+    */
+    void clear()
+    {
+        ADS_set temp(get_allocator());
+        temp.incremental_rehash_enabled = incremental_rehash_enabled;
+        temp.min_load_factor = min_load_factor;
+        temp.counters.swap(counters); // the statistics describe the life of the container, not of its table
+        temp.negative_filter(filter.enabled());
+        swap(temp);
+    }
+
+    /*
+    Removes all elements. With keep_capacity the table keeps its size and the memory of the nodes stays in element_pool,
+    so refilling the container up to its previous size neither rehashes nor allocates.
+    Only the non-empty buckets are visited (see occupancy). Complexity: O(size + table_size / 64)
+    */
+    void clear(bool keep_capacity);
+
+    /*
+    PH2: Removes the element key.
+    Return value: number of deleted elements (0 or 1).
+    For static hash procedures, it is not necessary to reduce an enlarged table again.
+    */
+    size_type erase(const key_type &key)
+    {
+        return eraseKey(key);
+    }
+
+    /*
+    Heterogeneous erase(), see enable_if_transparent
+    */
+    template <typename K, typename = enable_if_transparent<K>>
+    size_type erase(const K &key)
+    {
+        return eraseKey(key);
+    }
+
+    /*
+    Moves every element of source whose key is not stored in this container yet into this container
+    (keys that are stored in both stay in source). The table is grown once for all elements of source,
+    cached hash values are reused and the keys are moved, not copied (unless their move constructor may throw).
+    */
+    void merge(ADS_set &source);
+
+    void merge(ADS_set &&source)
+    {
+        merge(source);
+    }
+
+    /*
+    Removes every element for whose key predicate(key) is true. Return value: number of removed elements.
+    */
+    template <typename Predicate>
+    size_type erase_if(Predicate predicate);
+
+    /*
+    Turns incremental rehashing on or off (off by default).
+    When it is on, growing the table allocates the bigger table but moves the elements in small steps during the following
+    insert() and erase() calls, so no single insert() has to move all elements. Turning it off finishes a running migration.
+    */
+    void incremental_rehash(bool enabled)
+    {
+        incremental_rehash_enabled = enabled;
+        if (!enabled && old_table)
+        {
+            migrateBuckets(old_table_size);
+        }
+    }
+
+    /*
+    Turns the negative filter on or off (off by default). When it is on, a small counting Bloom filter of the hash values of all keys
+    (see ADS_counting_filter) is kept up to date by every insert and erase, and lookups of keys it rejects (about 99% of the
+    missing keys) return without loading a bucket or walking a chain. It costs about 6 bytes per key (at most
+    ADS_counting_filter::MAX_BYTES) and one more cache miss for every insert, erase and lookup of a stored key.
+    Turning it on, and growing it when the table grows, hashes all keys again unless the hash values are cached.
+    stats() reports its size and its false positive rate.
+    */
+    void negative_filter(bool enabled)
+    {
+        if (!enabled)
+        {
+            filter.reset();
+        }
+        else if (!filter.enabled())
+        {
+            rebuildFilter();
+        }
+    }
+
+    /*
+    Makes sure n elements fit into the table without exceeding the max load factor, grows (rehashes) the table if necessary.
+    A following bulk insert of n elements does not rehash again.
+    */
+    void reserve(size_type n);
+
+    /*
+    Rebuilds the table with at least n buckets (more if the stored elements would exceed the max load factor).
+    n smaller than the current table size shrinks the table. Elements are relinked, not copied.
+    */
+    void rehash(size_type n);
+
+    /*
+    Gives back the memory the elements do not need any more: the table is shrunk to the smallest size that keeps the
+    max load factor and the elements are moved into new slabs, so the slabs of erased elements are freed as well.
+    Complexity: O(size)
+    */
+    void shrink_to_fit();
+
+    /*
+    Lets erase() shrink the table once fewer than min_load_factor * table_size elements are stored (0 turns it off, default).
+    The table is shrunk to half of the max load factor, so an insert() right after the shrink does not grow it again.
+    For the same reason min_load_factor is limited to a quarter of the max load factor (larger values are reduced to that).
+    */
+    void shrink_on_erase(float min_load_factor)
+    {
+        this->min_load_factor = std::max(0.0f, std::min(min_load_factor, max_load_factor / 4));
+    }
+
+    /*
+    PH2: Return value: an iterator on the element with the key, or the end iterator (see end()) if no such element exists.
+    Complexity: hashing O(1)
+    */
+    iterator find(const key_type &key) const
+    {
+        return findKey(key);
+    }
+
+    /*
+    Heterogeneous find(), see enable_if_transparent
+    */
+    template <typename K, typename = enable_if_transparent<K>>
+    iterator find(const K &key) const
+    {
+        return findKey(key);
+    }
+
+    /*
+    PH2: Swaps the elements of the container with the elements of the container other.Complexity: O(1)
+    */
+    void swap(ADS_set &other)
+    {
+        std::swap(table, other.table);
+        std::swap(inserted_elements, other.inserted_elements);
+        std::swap(table_size, other.table_size);
+        std::swap(max_load_factor, other.max_load_factor);
+        std::swap(min_load_factor, other.min_load_factor);
+        element_pool.swap(other.element_pool);
+        std::swap(incremental_rehash_enabled, other.incremental_rehash_enabled);
+        std::swap(old_table, other.old_table);
+        std::swap(old_table_size, other.old_table_size);
+        std::swap(migrated_buckets, other.migrated_buckets);
+        std::swap(occupancy, other.occupancy);
+        std::swap(old_occupancy, other.old_occupancy);
+        std::swap(first_occupied, other.first_occupied);
+        std::swap(fingerprint, other.fingerprint);
+        counters.swap(other.counters);
+        filter.swap(other.filter);
+    }
+
+    /*
+    Return value: copy of the allocator the Element nodes are allocated with
+    */
+    allocator_type get_allocator() const
+    {
+        return element_pool.get_allocator();
+    }
+
+    /*
+    PH2: Return value: Iterator on the first element or the end iterator if the container is empty. Complexity: O(1)
+    */
+    const_iterator begin() const
+    {
+        if (first_occupied < table_size)
+        {
+            return iteratorAt(table[first_occupied], first_occupied);
+        }
+        if (first_occupied < table_size + old_table_size)
+        {
+            return iteratorAt(old_table[first_occupied - table_size], first_occupied);
+        }
+        return end();
+    }
+
+    /*
+    PH2: Returns an iterator to the (virtual) element after the last element in the container ("end iterator").
+    Return value: End iterator
+    */
+    const_iterator end() const
+    {
+        return iteratorAt(nullptr, table_size + old_table_size);
+    }
+
+    /*
+    Output the container contents to the stream o. There is no default for the functionality of dump(), i.e. it is not prescribed what the method writes to the stream. It is also permissible for the method to output nothing. However, it is recommended to output at least all contained elements. With testing it can be helpful beyond that, if the output represents in some form also the condition of the data structure.
+    The unit test outputs the contents of the container with the help of this method in the event of errors, in order to facilitate troubleshooting. However, if the output is overly large, the unit test may truncate it. It may be assumed that the container is instantiated during unit testing only with element data types (key_type) that support the output operator (<<).
+    ADS_dump::summary only prints stats(), which stays readable for tables of any size.
+    */
+    void dump(std::ostream &o = std::cerr, ADS_dump mode = ADS_dump::full) const;
+
+    /*
+    Return value: load factor, chain lengths, memory and the event counters (see ADS_set_stats). Complexity: O(table_size + size)
+    */
+    ADS_set_stats stats() const;
+
+    /* ------- OPERATORS ------- */
+
+    /*
+    PH2: Checks if the contents of two containers are equal. The contents are equal if the containers are of the same size and for each element in lhs there is an element in rhs with the same key. Return value: true if the container contents are equal, false otherwise. Complexity: O(size), O(1) if the fingerprints differ.
+    */
+    friend bool operator==(const ADS_set &lhs, const ADS_set &rhs)
+    {
+        // same number of inserted elements and same fingerprint?
+        if (lhs.inserted_elements != rhs.inserted_elements || lhs.fingerprint != rhs.fingerprint)
+        {
+            return false;
+        }
+        // with the same table size every key is in the same bucket in both tables, the tables are compared bucket by bucket
+        if (lhs.table_size == rhs.table_size && !lhs.old_table && !rhs.old_table)
+        {
+            return lhs.sameBuckets(rhs);
+        }
+        for (const auto &key : lhs)
+        {
+            if (rhs.locate(key) == nullptr)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+    PH2: Checks if the contents of two containers are not equal.
+    Return value: false if the container contents are equal, true otherwise. Complexity: O(size).
+    */
+    friend bool operator!=(const ADS_set &lhs, const ADS_set &rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    /*
+    PH2: Overload of Assignment Operator, Copy assignment operator -> The contents of the container will be replaced by the contents of other
+    */
+    ADS_set &operator=(const ADS_set &other)
+    {
+        // don't swap if the contents are the same
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        ADS_set temporary{other};
+        swap(temporary);
+        return *this;
+    }
+
+    /*
+    Move assignment operator. The elements of this container are destroyed and the ones of other are taken over, other is left empty.
+    */
+    ADS_set &operator=(ADS_set &&other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        ADS_set temporary{std::move(other)};
+        swap(temporary);
+        return *this;
+    }
+
+    /*
+    PH2: Copy assignment operator. The contents of the container will be replaced by the contents of other. Return value: reference to *this  Complexity: hashing: O(size + other_size)
+    */
+    ADS_set &operator=(std::initializer_list<key_type> ilist)
+    {
+        ADS_set temporary{ilist};
+        swap(temporary);
+        return *this;
+    }
+};
+
+/* ------- CONTAINER PRIVATE METHODS IMPLEMENTATION ------- */
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename InputIt>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::insert(InputIt first, InputIt last)
+{
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value)
+    {
+        // may reserve more than needed if the range contains duplicates, but the table grows at most once
+        reserve(inserted_elements + size_type(std::distance(first, last)));
+        addRange(first, last, true);
+    }
+    else
+    {
+        // single pass range: the size is unknown, the load factor is checked per key
+        for (auto it{first}; it != last; ++it)
+        {
+            if (old_table)
+            {
+                migrateBuckets(MIGRATION_STEP);
+            }
+            const key_type &key{*it};
+            size_type full_hash{hasher{}(key)};
+            size_type bucket;
+            if (!locate(key, full_hash, bucket)) // if el not found
+            {
+                reserve(inserted_elements + 1);
+                add(key, full_hash);
+            }
+        }
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename RandomIt>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::buildParallel(RandomIt first, RandomIt last, unsigned threads)
+{
+    const size_type key_count{size_type(last - first)};
+    reserve(key_count);
+    // the bucket ranges are whole occupancy words, so there must be at least one word per thread
+    const size_type word_count{ADS_bitmap::words(table_size)};
+    threads = unsigned(std::min<size_type>(threads, word_count));
+    if (threads <= 1 || key_count / threads < MIN_KEYS_PER_THREAD)
+    {
+        insert(first, last);
+        return;
+    }
+
+    // thread part owns the buckets [bucket_start[part], bucket_start[part + 1])
+    std::vector<size_type> bucket_start(threads + 1);
+    for (unsigned part{0}; part <= threads; ++part)
+    {
+        bucket_start[part] = std::min(table_size, word_count * part / threads * ADS_bitmap::WORD_BITS);
+    }
+    auto owner{[&bucket_start, threads](size_type bucket)
+               {
+                   return unsigned(std::upper_bound(bucket_start.begin() + 1, bucket_start.begin() + threads, bucket) - bucket_start.begin() - 1);
+               }};
+
+    // 1. hash every slice, counts[slice * threads + part]: keys of slice that belong to part
+    std::vector<size_type> hashes(key_count);
+    std::vector<size_type> counts(size_type(threads) * threads);
+    ADS_parallel(threads, [&](unsigned slice)
+                 {
+                     for (size_type index{key_count * slice / threads}; index < key_count * (slice + 1) / threads; ++index)
+                     {
+                         hashes[index] = hasher{}(first[std::ptrdiff_t(index)]);
+                         ++counts[slice * threads + owner(bucketIndex(hashes[index], table_size))];
+                     }
+                 });
+
+    // 2. the keys of a part are stored together, ordered by slice
+    std::vector<size_type> part_start(threads + 1);
+    std::vector<size_type> offsets(counts.size());
+    size_type offset{0};
+    for (unsigned part{0}; part < threads; ++part)
+    {
+        part_start[part] = offset;
+        for (unsigned slice{0}; slice < threads; ++slice)
+        {
+            offsets[slice * threads + part] = offset;
+            offset += counts[slice * threads + part];
+        }
+    }
+    part_start[threads] = key_count;
+    std::vector<size_type> order(key_count);
+    ADS_parallel(threads, [&](unsigned slice)
+                 {
+                     for (size_type index{key_count * slice / threads}; index < key_count * (slice + 1) / threads; ++index)
+                     {
+                         order[offsets[slice * threads + owner(bucketIndex(hashes[index], table_size))]++] = index;
+                     }
+                 });
+
+    // 3. every part links its keys with nodes from its own block (one node per key, duplicates leave some unused)
+    std::vector<Element *> blocks(threads, nullptr);
+    for (unsigned part{0}; part < threads; ++part)
+    {
+        if (part_start[part + 1] > part_start[part])
+        {
+            blocks[part] = element_pool.allocateBlock(part_start[part + 1] - part_start[part]);
+        }
+    }
+    std::vector<size_type> linked(threads);
+    std::vector<size_type> part_fingerprints(threads);
+    std::exception_ptr error;
+    try
+    {
+        ADS_parallel(threads, [&](unsigned part)
+                     {
+                         for (size_type position{part_start[part]}; position < part_start[part + 1]; ++position)
+                         {
+                             const key_type &key{first[std::ptrdiff_t(order[position])]};
+                             const size_type full_hash{hashes[order[position]]};
+                             const size_type bucket{bucketIndex(full_hash, table_size)};
+                             bool duplicate{false};
+                             for (const Element *elementPtr{table[bucket]}; elementPtr && !duplicate; elementPtr = elementPtr->nextPtr)
+                             {
+                                 duplicate = holds(elementPtr, key, full_hash);
+                             }
+                             if (duplicate)
+                             {
+                                 continue;
+                             }
+                             table[bucket] = ::new (static_cast<void *>(blocks[part] + linked[part])) Element{full_hash, key, table[bucket]};
+                             ADS_bitmap::set(occupancy, bucket);
+                             ++linked[part];
+                             part_fingerprints[part] += fingerprintOf(full_hash);
+                         }
+                     });
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    // if a key could not be copied, the keys linked before stay in the container (and are destroyed with it)
+    for (unsigned part{0}; part < threads; ++part)
+    {
+        inserted_elements += linked[part];
+        fingerprint += part_fingerprints[part];
+        for (size_type index{linked[part]}; index < part_start[part + 1] - part_start[part]; ++index)
+        {
+            element_pool.giveBack(blocks[part] + index);
+        }
+    }
+    first_occupied = ADS_bitmap::next(occupancy, 0, table_size);
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename ForwardIt>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::addRange(ForwardIt first, ForwardIt last, bool check_duplicates)
+{
+    size_type hashes[BULK_BATCH];
+
+    while (first != last)
+    {
+        // 1. hash the batch and request its buckets
+        ForwardIt batch_end{first};
+        size_type batch_size{0};
+        for (; batch_end != last && batch_size < BULK_BATCH; ++batch_end, ++batch_size)
+        {
+            hashes[batch_size] = hasher{}(*batch_end);
+            ADS_prefetch(table + bucketIndex(hashes[batch_size], table_size));
+        }
+
+        // 2. insert the batch, the buckets are (hopefully) in the cache by now
+        for (size_type index{0}; index < batch_size; ++index, ++first)
+        {
+            size_type bucket;
+            if (!check_duplicates || !locate(*first, hashes[index], bucket))
+            {
+                add(*first, hashes[index]);
+            }
+        }
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename ForwardIt, typename Function>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::locateBatch(ForwardIt first, ForwardIt last, Function function) const
+{
+    ForwardIt keys[BULK_BATCH];
+    size_type hashes[BULK_BATCH];
+    size_type buckets[BULK_BATCH];
+    Element *cursors[BULK_BATCH];
+    bool finished[BULK_BATCH];
+
+    while (first != last)
+    {
+        // 1. hash the batch and request its buckets
+        size_type batch_size{0};
+        for (; first != last && batch_size < BULK_BATCH; ++first, ++batch_size)
+        {
+            keys[batch_size] = first;
+            hashes[batch_size] = hasher{}(*first);
+            buckets[batch_size] = bucketIndex(hashes[batch_size], table_size);
+            // keys rejected by the negative filter do not need their bucket
+            finished[batch_size] = !filter.mayContain(hashes[batch_size]);
+            if (!finished[batch_size])
+            {
+                ADS_prefetch(table + buckets[batch_size]);
+            }
+        }
+
+        // 2. read the chain heads and request the first nodes
+        size_type pending{0};
+        for (size_type index{0}; index < batch_size; ++index)
+        {
+            cursors[index] = finished[index] ? nullptr : table[buckets[index]];
+            finished[index] = !cursors[index];
+            if (cursors[index])
+            {
+                ADS_prefetch(cursors[index]);
+                ++pending;
+            }
+        }
+
+        // 3. every round compares one node per lookup and requests the next one, until all lookups found their key or a chain end
+        while (pending)
+        {
+            for (size_type index{0}; index < batch_size; ++index)
+            {
+                if (finished[index])
+                {
+                    continue;
+                }
+                if (holds(cursors[index], *keys[index], hashes[index]))
+                {
+                    finished[index] = true;
+                    --pending;
+                    continue;
+                }
+                cursors[index] = cursors[index]->nextPtr;
+                if (cursors[index])
+                {
+                    ADS_prefetch(cursors[index]);
+                }
+                else
+                {
+                    finished[index] = true;
+                    --pending;
+                }
+            }
+        }
+
+        // 4. report in key order, keys that were not found may still be in a bucket of old_table that was not migrated yet
+        for (size_type index{0}; index < batch_size; ++index)
+        {
+            Element *element{cursors[index]};
+            size_type bucket{buckets[index]};
+            if (!element && old_table)
+            {
+                element = locate(*keys[index], hashes[index], bucket);
+            }
+            if (!function(element, bucket))
+            {
+                return;
+            }
+        }
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::hash(const key_type &key) const
+{
+    return bucketIndex(hasher{}(key), table_size);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::elementHash(const Element *elementPtr) const
+{
+    if constexpr (cache_hash)
+    {
+        return elementPtr->hash_value;
+    }
+    else
+    {
+        return hasher{}(elementPtr->key);
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::Element *ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::add(K &&key, size_type full_hash)
+{
+    size_type index{bucketIndex(full_hash, table_size)};
+
+    // new element becomes the head of the chain (nullptr if the slot was empty)
+    table[index] = element_pool.acquire(full_hash, std::forward<K>(key), table[index]);
+    markOccupied(index);
+    ++inserted_elements;
+    fingerprint += fingerprintOf(full_hash);
+    filter.add(full_hash);
+
+    return table[index];
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::link(Element *elementPtr, size_type full_hash)
+{
+    if constexpr (cache_hash)
+    {
+        elementPtr->hash_value = full_hash;
+    }
+    size_type index{bucketIndex(full_hash, table_size)};
+    elementPtr->nextPtr = table[index];
+    table[index] = elementPtr;
+    markOccupied(index);
+    ++inserted_elements;
+    fingerprint += fingerprintOf(full_hash);
+    filter.add(full_hash);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename K>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::iterator, bool> ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::insertKey(K &&key, size_type full_hash)
+{
+    if (old_table)
+    {
+        migrateBuckets(MIGRATION_STEP);
+    }
+
+    size_type bucket;
+    Element *element{locate(key, full_hash, bucket)};
+    if (element) // element exists?
+    {
+        return {iteratorAt(element, bucket), false};
+    }
+
+    // check with load factor condition and insert new element
+    reserve(inserted_elements + 1);
+    element = add(std::forward<K>(key), full_hash);
+    return {iteratorAt(element, bucketIndex(full_hash, table_size)), true};
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename... Args>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::iterator, bool> ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::emplace(Args &&...args)
+{
+    if (old_table)
+    {
+        migrateBuckets(MIGRATION_STEP);
+    }
+
+    // the key only exists once it is constructed, so it is built in a new (not yet linked) element first
+    Element *elementPtr{element_pool.emplace(std::forward<Args>(args)...)};
+    size_type full_hash;
+    size_type bucket;
+    Element *element;
+    try
+    {
+        full_hash = hasher{}(elementPtr->key);
+        element = locate(elementPtr->key, full_hash, bucket);
+        if (!element)
+        {
+            reserve(inserted_elements + 1);
+        }
+    }
+    catch (...)
+    {
+        element_pool.release(elementPtr);
+        throw;
+    }
+
+    if (element) // element exists?
+    {
+        element_pool.release(elementPtr);
+        return {iteratorAt(element, bucket), false};
+    }
+    link(elementPtr, full_hash);
+    return {iteratorAt(elementPtr, bucketIndex(full_hash, table_size)), true};
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::eraseKey(const K &key, size_type full_hash)
+{
+    if (old_table)
+    {
+        migrateBuckets(MIGRATION_STEP);
+    }
+
+    size_type bucket{bucketIndex(full_hash, table_size)};
+    size_type old_bucket{old_table ? bucketIndex(full_hash, old_table_size) : 0};
+    if (eraseFromChain(table[bucket], key, full_hash))
+    {
+        if (!table[bucket])
+        {
+            markEmpty(bucket);
+        }
+    }
+    // not migrated yet?
+    else if (old_table && old_bucket >= migrated_buckets && eraseFromChain(old_table[old_bucket], key, full_hash))
+    {
+        if (!old_table[old_bucket])
+        {
+            markEmpty(table_size + old_bucket);
+        }
+    }
+    else
+    {
+        return 0;
+    }
+    shrinkIfSparse();
+    return 1;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::Element *ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::locate(const K &key, size_type full_hash, size_type &bucket) const
+{
+    bucket = bucketIndex(full_hash, table_size);
+    if (!filter.mayContain(full_hash))
+    {
+        counters.countFiltered();
+        return nullptr;
+    }
+    Element *currentElementPtr = table[bucket];
+    uint64_t probes{0}; // only used if ADS_SET_STATS is defined
+
+    while (currentElementPtr)
+    {
+        ++probes;
+        if (holds(currentElementPtr, key, full_hash))
+        {
+            // return it if exists
+            counters.countLookup(probes);
+            return currentElementPtr;
+        }
+        currentElementPtr = currentElementPtr->nextPtr;
+    }
+
+    // during an incremental rehash the key may still be in a bucket of old_table that has not been migrated
+    if (old_table && bucketIndex(full_hash, old_table_size) >= migrated_buckets)
+    {
+        size_type old_bucket{bucketIndex(full_hash, old_table_size)};
+        for (currentElementPtr = old_table[old_bucket]; currentElementPtr; currentElementPtr = currentElementPtr->nextPtr)
+        {
+            ++probes;
+            if (holds(currentElementPtr, key, full_hash))
+            {
+                bucket = table_size + old_bucket;
+                counters.countLookup(probes);
+                return currentElementPtr;
+            }
+        }
+    }
+    counters.countLookup(probes);
+    if (filter.enabled())
+    {
+        counters.countFalsePositive();
+    }
+    return nullptr; // the key not found
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename K>
+bool ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::eraseFromChain(Element *&head, const K &key, size_type full_hash)
+{
+    Element *elementPtr{head};
+    Element *auxElementPtr{nullptr};
+
+    while (elementPtr)
+    {
+        if (holds(elementPtr, key, full_hash))
+        {
+            if (auxElementPtr)
+            {
+                auxElementPtr->nextPtr = elementPtr->nextPtr;
+            }
+            else
+            {
+                head = elementPtr->nextPtr;
+            }
+
+            element_pool.release(elementPtr);
+            --inserted_elements;
+            fingerprint -= fingerprintOf(full_hash);
+            filter.remove(full_hash);
+
+            return true;
+        }
+        auxElementPtr = elementPtr;
+        elementPtr = auxElementPtr->nextPtr;
+    }
+    return false;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::cloneFrom(const ADS_set &other)
+{
+    // copied first: an empty container keeps its filter setting as well
+    filter = other.filter;
+    fingerprint = other.fingerprint;
+    if (!other.ownsTable())
+    {
+        return;
+    }
+    if (table_size != other.table_size || !ownsTable())
+    {
+        Element **new_table{new Element *[other.table_size] {}};
+        ADS_bitmap::word_t *new_occupancy;
+        try
+        {
+            new_occupancy = new ADS_bitmap::word_t[ADS_bitmap::words(other.table_size)]{};
+        }
+        catch (...)
+        {
+            delete[] new_table;
+            throw;
+        }
+        if (ownsTable())
+        {
+            delete[] table;
+            delete[] occupancy;
+        }
+        table = new_table;
+        occupancy = new_occupancy;
+        table_size = other.table_size;
+        first_occupied = table_size;
+    }
+    if (!other.inserted_elements)
+    {
+        return;
+    }
+
+    Element *block{element_pool.allocateBlock(other.inserted_elements)};
+    size_type used{0};
+    try
+    {
+        for (size_type bucket{ADS_bitmap::next(other.occupancy, 0, table_size)}; bucket < table_size;
+             bucket = ADS_bitmap::next(other.occupancy, bucket + 1, table_size))
+        {
+            // every copy is appended to the chain, so the order of the chain stays the same
+            Element **tail{table + bucket};
+            for (const Element *source{other.table[bucket]}; source; source = source->nextPtr)
+            {
+                Element *copy{block + used};
+                if constexpr (std::is_trivially_copyable<Element>::value)
+                {
+                    std::memcpy(static_cast<void *>(copy), static_cast<const void *>(source), sizeof(Element));
+                    copy->nextPtr = nullptr;
+                }
+                else
+                {
+                    ::new (static_cast<void *>(copy)) Element{static_cast<const ADS_element_hash<cache_hash> &>(*source), source->key, nullptr};
+                }
+                ++used;
+                *tail = copy;
+                tail = &copy->nextPtr;
+            }
+        }
+    }
+    catch (...)
+    {
+        // the copied keys are linked and destroyed with the container, the rest of the block is unused
+        for (; used < other.inserted_elements; ++used)
+        {
+            element_pool.giveBack(block + used);
+        }
+        throw;
+    }
+    std::copy_n(other.occupancy, ADS_bitmap::words(table_size), occupancy);
+    inserted_elements = other.inserted_elements;
+    first_occupied = other.first_occupied;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::destroyChains(Element **buckets, size_type bucket_count)
+{
+    // keys with a destructor have to be destroyed one by one, the slabs themselves are freed at once by element_pool
+    if (std::is_trivially_destructible<key_type>::value)
+    {
+        return;
+    }
+    for (size_type index{0}; index < bucket_count; ++index)
+    {
+        Element *currentElement = buckets[index];
+        while (currentElement)
+        {
+            Element *nextPtr = currentElement->nextPtr;
+            element_pool.destroy(currentElement);
+            currentElement = nextPtr;
+        }
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::moveChain(Element *currentElementPtr)
+{
+    // the elements are not copied, every node is unlinked from its old chain and becomes the head of its new chain
+    while (currentElementPtr)
+    {
+        Element *auxPtr = currentElementPtr;
+        currentElementPtr = auxPtr->nextPtr;
+
+        size_type new_index{bucketIndex(elementHash(auxPtr), table_size)};
+        auxPtr->nextPtr = table[new_index];
+        table[new_index] = auxPtr;
+        markOccupied(new_index);
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::migrateBuckets(size_type bucket_count)
+{
+    auto start{counters.startTimer()};
+    for (; bucket_count && migrated_buckets < old_table_size; --bucket_count, ++migrated_buckets)
+    {
+        if (old_table[migrated_buckets])
+        {
+            // the moved elements are in table now, so first_occupied is already below this bucket
+            moveChain(old_table[migrated_buckets]);
+            old_table[migrated_buckets] = nullptr; // iterators skip the migrated buckets
+            ADS_bitmap::reset(old_occupancy, migrated_buckets);
+        }
+    }
+    if (migrated_buckets == old_table_size)
+    {
+        // the end index moves from table_size + old_table_size to table_size
+        first_occupied = std::min(first_occupied, table_size);
+        delete[] old_table;
+        delete[] old_occupancy;
+        old_occupancy = nullptr;
+        old_table = nullptr;
+        old_table_size = 0;
+        migrated_buckets = 0;
+    }
+    counters.stopTimer(start);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::reserve(size_type n)
+{
+    if ((table_size * max_load_factor) >= n)
+    {
+        return;
+    }
+
+    size_type new_table_size{table_size};
+
+    while (new_table_size * max_load_factor < n)
+    {
+        if constexpr (power_of_two)
+        {
+            new_table_size *= 2;
+        }
+        else
+        {
+            ++(new_table_size *= 2); // to make sure we don't start from 0 because 0 * 2 = 0
+        }
+    }
+    rehash(new_table_size);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::rehash(size_type n)
+{
+    size_type new_table_size{
+        tableSizeFor(std::max(INITIAL_TABLE_SIZE,
+                              std::max(n,
+                                       size_type(
+                                           inserted_elements / max_load_factor))))};
+
+    // only one migration at a time, a running one is finished first
+    if (old_table)
+    {
+        migrateBuckets(old_table_size);
+    }
+
+    Element **new_table{new Element *[new_table_size] {}};
+    ADS_bitmap::word_t *new_occupancy;
+    try
+    {
+        new_occupancy = new ADS_bitmap::word_t[ADS_bitmap::words(new_table_size)]{};
+    }
+    catch (...)
+    {
+        delete[] new_table;
+        throw;
+    }
+    if (!ownsTable())
+    {
+        // the first table of the container, there is nothing to move
+        table = new_table;
+        table_size = new_table_size;
+        occupancy = new_occupancy;
+        first_occupied = new_table_size;
+    }
+    else
+    {
+        old_table = table;
+        old_table_size = table_size;
+        old_occupancy = occupancy;
+        migrated_buckets = 0;
+
+        table = new_table;
+        table_size = new_table_size;
+        occupancy = new_occupancy;
+        first_occupied += new_table_size; // the buckets of old_table now follow the (empty) new table
+        counters.countRehash();
+
+        // all at once, or the first step of an incremental rehash (the following ones are done by insert() and erase())
+        migrateBuckets(incremental_rehash_enabled ? MIGRATION_STEP : old_table_size);
+    }
+
+    // the filter grows with the table (until it reaches its maximum size), so its false positive rate stays low
+    if (filter.enabled() && filter.tooSmallFor(size_type(table_size * max_load_factor)))
+    {
+        rebuildFilter();
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::clear(bool keep_capacity)
+{
+    if (!keep_capacity)
+    {
+        clear();
+        return;
+    }
+    // a running migration is dropped, its elements are destroyed with the rest
+    if (old_table)
+    {
+        destroyChains(old_table, old_table_size);
+        delete[] old_table;
+        delete[] old_occupancy;
+        old_table = nullptr;
+        old_occupancy = nullptr;
+        old_table_size = 0;
+        migrated_buckets = 0;
+    }
+    for (size_type index{ADS_bitmap::next(occupancy, 0, table_size)}; index < table_size;
+         index = ADS_bitmap::next(occupancy, index + 1, table_size))
+    {
+        destroyChains(table + index, 1);
+        table[index] = nullptr;
+    }
+    if (ownsTable())
+    {
+        std::fill_n(occupancy, ADS_bitmap::words(table_size), 0);
+    }
+    element_pool.reset();
+    inserted_elements = 0;
+    fingerprint = 0;
+    filter.clear();
+    first_occupied = table_size;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+bool ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::sameBuckets(const ADS_set &other) const
+{
+    if (!std::equal(occupancy, occupancy + ADS_bitmap::words(table_size), other.occupancy))
+    {
+        return false;
+    }
+    for (size_type index{nextOccupied(0)}; index < table_size; index = nextOccupied(index + 1))
+    {
+        for (const Element *elementPtr{table[index]}; elementPtr; elementPtr = elementPtr->nextPtr)
+        {
+            size_type full_hash{elementHash(elementPtr)};
+            const Element *otherPtr{other.table[index]};
+            while (otherPtr && !holds(otherPtr, elementPtr->key, full_hash))
+            {
+                otherPtr = otherPtr->nextPtr;
+            }
+            if (!otherPtr)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::merge(ADS_set &source)
+{
+    if (&source == this)
+    {
+        return;
+    }
+    reserve(inserted_elements + source.inserted_elements);
+    for (size_type index{source.nextOccupied(0)}; index < source.bucketCount(); index = source.nextOccupied(index + 1))
+    {
+        Element **linkPtr{index < source.table_size ? &source.table[index] : &source.old_table[index - source.table_size]};
+        while (Element *elementPtr{*linkPtr})
+        {
+            size_type full_hash{source.elementHash(elementPtr)};
+            size_type bucket;
+            if (locate(elementPtr->key, full_hash, bucket))
+            {
+                linkPtr = &elementPtr->nextPtr;
+                continue;
+            }
+            add(std::move_if_noexcept(elementPtr->key), full_hash);
+            *linkPtr = elementPtr->nextPtr;
+            source.element_pool.release(elementPtr);
+            --source.inserted_elements;
+            source.fingerprint -= fingerprintOf(full_hash);
+            source.filter.remove(full_hash);
+        }
+        if (!source.bucketAt(index))
+        {
+            source.markEmpty(index);
+        }
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+template <typename Predicate>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::erase_if(Predicate predicate)
+{
+    size_type erased{0};
+    for (size_type index{nextOccupied(0)}; index < bucketCount(); index = nextOccupied(index + 1))
+    {
+        Element **linkPtr{index < table_size ? &table[index] : &old_table[index - table_size]};
+        while (Element *elementPtr{*linkPtr})
+        {
+            if (!predicate(static_cast<const key_type &>(elementPtr->key)))
+            {
+                linkPtr = &elementPtr->nextPtr;
+                continue;
+            }
+            *linkPtr = elementPtr->nextPtr;
+            size_type full_hash{elementHash(elementPtr)};
+            fingerprint -= fingerprintOf(full_hash);
+            filter.remove(full_hash);
+            element_pool.release(elementPtr);
+            --inserted_elements;
+            ++erased;
+        }
+        if (!bucketAt(index))
+        {
+            markEmpty(index);
+        }
+    }
+    if (erased)
+    {
+        shrinkIfSparse();
+    }
+    return erased;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::shrinkIfSparse()
+{
+    // not during a migration, the table that is migrated into is the one that would be shrunk
+    if (old_table || table_size <= INITIAL_TABLE_SIZE || inserted_elements >= table_size * min_load_factor)
+    {
+        return;
+    }
+    rehash(size_type(inserted_elements / (max_load_factor / 2)));
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::rebuildFilter()
+{
+    // built aside, a hasher that throws must not leave a filter behind that misses keys
+    ADS_counting_filter rebuilt;
+    rebuilt.resize(std::max(inserted_elements, size_type(table_size * max_load_factor)));
+    for (size_type index{nextOccupied(0)}; index < bucketCount(); index = nextOccupied(index + 1))
+    {
+        for (const Element *elementPtr{bucketAt(index)}; elementPtr; elementPtr = elementPtr->nextPtr)
+        {
+            rebuilt.add(elementHash(elementPtr));
+        }
+    }
+    filter.swap(rebuilt);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::shrink_to_fit()
+{
+    ADS_set temp(get_allocator());
+    temp.negative_filter(filter.enabled());
+    temp.reserve(inserted_elements);
+    if (inserted_elements)
+    {
+        // the hash values and all new nodes are ready before the first key moves. A key is moved only if that cannot throw,
+        // then nothing else can throw either; a key that is copied instead may throw, and this set still holds all its keys
+        std::vector<size_type> hashes;
+        hashes.reserve(inserted_elements);
+        for (size_type index{0}; index < table_size + old_table_size; ++index)
+        {
+            for (const Element *elementPtr{index < table_size ? table[index] : old_table[index - table_size]}; elementPtr;
+                 elementPtr = elementPtr->nextPtr)
+            {
+                hashes.push_back(elementHash(elementPtr));
+            }
+        }
+        Element *block{temp.element_pool.allocateBlock(inserted_elements)};
+        size_type used{0};
+        try
+        {
+            for (size_type index{0}; index < table_size + old_table_size; ++index)
+            {
+                for (Element *elementPtr{index < table_size ? table[index] : old_table[index - table_size]}; elementPtr;
+                     elementPtr = elementPtr->nextPtr)
+                {
+                    ::new (static_cast<void *>(block + used)) Element{hashes[used], std::move_if_noexcept(elementPtr->key), nullptr};
+                    temp.link(block + used, hashes[used]);
+                    ++used;
+                }
+            }
+        }
+        catch (...)
+        {
+            // the linked copies are destroyed with temp, the rest of the block is unused
+            for (; used < inserted_elements; ++used)
+            {
+                temp.element_pool.giveBack(block + used);
+            }
+            throw;
+        }
+    }
+    temp.counters.swap(counters);
+    temp.incremental_rehash_enabled = incremental_rehash_enabled;
+    temp.min_load_factor = min_load_factor;
+    swap(temp);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set_stats ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::stats() const
+{
+    ADS_set_stats stats;
+    stats.size = inserted_elements;
+    stats.bucket_count = table_size + old_table_size;
+    stats.load_factor = double(inserted_elements) / double(stats.bucket_count);
+    size_type empty_buckets{0};
+    for (size_type index{0}; index < table_size + old_table_size; ++index)
+    {
+        size_type length{0};
+        for (const Element *elementPtr{bucketAt(index)}; elementPtr; elementPtr = elementPtr->nextPtr)
+        {
+            ++length;
+        }
+        if (length >= stats.chain_lengths.size())
+        {
+            stats.chain_lengths.resize(length + 1);
+        }
+        ++stats.chain_lengths[length];
+        empty_buckets += length == 0;
+        stats.max_chain = std::max(stats.max_chain, length);
+    }
+    stats.empty_bucket_ratio = double(empty_buckets) / double(stats.bucket_count);
+    const size_type own_buckets{ownsTable() ? table_size : 0}; // the shared empty table is not counted
+    stats.bytes = (own_buckets + old_table_size) * sizeof(Element *) +
+                  (ADS_bitmap::words(own_buckets) + ADS_bitmap::words(old_table_size)) * sizeof(ADS_bitmap::word_t) +
+                  element_pool.bytes() + filter.bytes();
+    stats.filter_bytes = filter.bytes();
+    stats.filter_false_positive_rate = filter.falsePositiveRate();
+    counters.fill(stats);
+    return stats;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::dump(std::ostream &o, ADS_dump mode) const
+{
+    if (mode == ADS_dump::summary)
+    {
+        o << stats();
+        return;
+    }
+
+    Element *current_element_ptr;
+
+    o << "table_size = " << table_size << ", inserted_elements = " << inserted_elements << "\n";
+    // buckets of a table that is still being migrated are printed after the ones of the new table
+    for (size_type index{0}; index < table_size + old_table_size; ++index)
+    {
+        if (index == table_size)
+        {
+            o << "old_table_size = " << old_table_size << ", migrated_buckets = " << migrated_buckets << "\n";
+        }
+        Element *bucket{index < table_size ? table[index] : old_table[index - table_size]};
+
+        o << index << ": ";
+        if (bucket == nullptr)
+        {
+            o << "--FREE \n";
+            continue;
+        }
+
+        o << "[";
+
+        current_element_ptr = bucket;
+
+        while (current_element_ptr)
+        {
+            o << current_element_ptr->key;
+            current_element_ptr = current_element_ptr->nextPtr;
+            if (current_element_ptr)
+            {
+                o << " -> ";
+            }
+        }
+        o << "]\n";
+    }
+    o << "\n";
+}
+
+/* ------- ELEMENT POOL ------- */
+/*
+Element nodes are not allocated one by one. The pool requests slabs from the allocator (the first one holds
+FIRST_SLAB_SIZE nodes, every following one twice as many up to MAX_SLAB_SIZE) and hands out the nodes with a bump pointer.
+Released nodes are put on a free list (the storage of the destroyed node holds the link) and are reused before the slab is touched.
+allocateBlock() hands out many consecutive nodes at once in a slab of their own, for bulk builds that fill the nodes themselves.
+All slabs are returned to the allocator at once when the pool is destroyed.
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+class ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::ElementPool
+{
+private:
+    using element_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Element>;
+    using element_traits = std::allocator_traits<element_allocator>;
+
+    /* nodes: storage of size Elements */
+    struct Slab
+    {
+        Element *nodes;
+        size_type size;
+    };
+
+    using slab_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slab>;
+
+    static constexpr size_type FIRST_SLAB_SIZE{8};
+    static constexpr size_type MAX_SLAB_SIZE{4096};
+
+    /* a released node, lives in the storage of the destroyed Element */
+    struct FreeElement
+    {
+        FreeElement *nextFree;
+    };
+
+    element_allocator allocator;
+    std::vector<Slab, slab_allocator> slabs;     // every slab ever allocated, in order of use
+    FreeElement *free_list{nullptr};             // released nodes ready to be reused
+    Element *bump_next{nullptr};                 // next untouched node in the current slab
+    Element *bump_end{nullptr};                  // end of the current slab
+    size_type used_slabs{0};                     // slabs the bump pointer has been in (after reset() the old slabs are reused)
+
+    /* size of a new slab for the bump pointer, depends on the number of slabs before it */
+    static size_type slabSize(size_type slab_index)
+    {
+        size_type size{FIRST_SLAB_SIZE};
+        while (slab_index-- && size < MAX_SLAB_SIZE)
+        {
+            size *= 2;
+        }
+        return size;
+    }
+
+    /* returns uninitialized storage for one Element */
+    Element *allocate()
+    {
+        if (free_list)
+        {
+            FreeElement *freeElement{free_list};
+            free_list = freeElement->nextFree;
+            return reinterpret_cast<Element *>(freeElement);
+        }
+        if (bump_next == bump_end)
+        {
+            if (used_slabs == slabs.size())
+            {
+                size_type size{slabSize(used_slabs)};
+                slabs.reserve(slabs.size() + 1); // so push_back cannot throw and leak the slab
+                slabs.push_back(Slab{element_traits::allocate(allocator, size), size});
+            }
+            bump_next = slabs[used_slabs].nodes;
+            bump_end = bump_next + slabs[used_slabs].size;
+            ++used_slabs;
+        }
+        return bump_next++;
+    }
+
+    /* puts the storage of an already destroyed Element on the free list */
+    void deallocate(Element *elementPtr)
+    {
+        free_list = ::new (static_cast<void *>(elementPtr)) FreeElement{free_list};
+    }
+
+public:
+    static_assert(sizeof(Element) >= sizeof(FreeElement), "Element too small to hold a free list link");
+
+    explicit ElementPool(const Allocator &allocator) : allocator{allocator}, slabs{slab_allocator{allocator}} {}
+
+    ElementPool(const ElementPool &) = delete;
+    ElementPool &operator=(const ElementPool &) = delete;
+
+    /* all live nodes must have been destroyed already, only the raw slabs are left */
+    ~ElementPool()
+    {
+        for (const Slab &slab : slabs)
+        {
+            element_traits::deallocate(allocator, slab.nodes, slab.size);
+        }
+    }
+
+    /* creates a new node, the arguments are the members of Element in declaration order (hash value, key, nextPtr) */
+    template <typename... Args>
+    Element *acquire(Args &&...args)
+    {
+        Element *elementPtr{allocate()};
+        try
+        {
+            ::new (static_cast<void *>(elementPtr)) Element{std::forward<Args>(args)...};
+        }
+        catch (...)
+        {
+            deallocate(elementPtr);
+            throw;
+        }
+        return elementPtr;
+    }
+
+    /* creates a new node that is not linked yet, its key is constructed in place from key_args (the hash value is left 0) */
+    template <typename... Args>
+    Element *emplace(Args &&...key_args)
+    {
+        Element *elementPtr{allocate()};
+        try
+        {
+            ::new (static_cast<void *>(elementPtr)) Element{size_type{0}, key_type(std::forward<Args>(key_args)...), nullptr};
+        }
+        catch (...)
+        {
+            deallocate(elementPtr);
+            throw;
+        }
+        return elementPtr;
+    }
+
+    /* destroys the node without reusing its storage (used when the whole pool goes away) */
+    void destroy(Element *elementPtr)
+    {
+        elementPtr->~Element();
+    }
+
+    /* destroys the node and keeps its storage for the next acquire() */
+    void release(Element *elementPtr)
+    {
+        destroy(elementPtr);
+        deallocate(elementPtr);
+    }
+
+    /* memory of all slabs */
+    size_type bytes() const
+    {
+        size_type total{slabs.capacity() * sizeof(Slab)};
+        for (const Slab &slab : slabs)
+        {
+            total += slab.size * sizeof(Element);
+        }
+        return total;
+    }
+
+    /*
+    Uninitialized storage for count consecutive nodes in a new slab of their own (count > 0).
+    Every node of the block has to be constructed by the caller or given back with giveBack().
+    */
+    Element *allocateBlock(size_type count)
+    {
+        slabs.reserve(slabs.size() + 1); // so insert cannot throw and leak the slab
+        Element *nodes{element_traits::allocate(allocator, count)};
+        // slabs kept by reset() stay behind the used ones, the bump pointer takes them next
+        slabs.insert(slabs.begin() + std::ptrdiff_t(used_slabs), Slab{nodes, count});
+        ++used_slabs;
+        return nodes;
+    }
+
+    /* puts unused storage of a block on the free list */
+    void giveBack(Element *elementPtr)
+    {
+        deallocate(elementPtr);
+    }
+
+    /* takes back the storage of all nodes at once and keeps the slabs, all nodes must have been destroyed already */
+    void reset()
+    {
+        free_list = nullptr;
+        bump_next = nullptr;
+        bump_end = nullptr;
+        used_slabs = 0;
+    }
+
+    void swap(ElementPool &other)
+    {
+        std::swap(allocator, other.allocator);
+        slabs.swap(other.slabs);
+        std::swap(free_list, other.free_list);
+        std::swap(bump_next, other.bump_next);
+        std::swap(bump_end, other.bump_end);
+        std::swap(used_slabs, other.used_slabs);
+    }
+
+    Allocator get_allocator() const
+    {
+        return Allocator(allocator);
+    }
+};
+
+/* ------- ITERATOR ------- */
 /*
+ PH2 Iterator must implement:
+ 1. at which element I am in the data structure
+ 2. how do I get to the next one
+ 3. how do I recognize the "end"
+ */
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+class ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::Iterator
+{
+private:
+    Element **table;
+    const ADS_bitmap::word_t *occupancy; // non-empty buckets of table
+    Element *current_element_ptr;
+    size_type index;
+    size_type table_size;
+    Element **old_table;     // during an incremental rehash its buckets are visited after the ones of table
+    const ADS_bitmap::word_t *old_occupancy;
+    size_type old_table_size;
+
+    /* moves to the first element of the next non-empty bucket if there is no current element */
+    void skip();
+
+public:
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type &;
+    using pointer = const value_type *;
+    using iterator_category = std::forward_iterator_tag;
+
+    /* default constructor that performs no conversions is required */
+    explicit Iterator(Element **table = nullptr,
+                      const ADS_bitmap::word_t *occupancy = nullptr,
+                      Element *current_element_ptr = nullptr,
+                      size_type index = 0,
+                      size_type table_size = 0,
+                      Element **old_table = nullptr,
+                      const ADS_bitmap::word_t *old_occupancy = nullptr,
+                      size_type old_table_size = 0)
+        : table{table}, occupancy{occupancy}, current_element_ptr{current_element_ptr}, index{index}, table_size{table_size},
+          old_table{old_table}, old_occupancy{old_occupancy}, old_table_size{old_table_size}
+    {
+        skip(); // do while current position
+    };
+
+    /* Pointer generalization */
+    reference operator*() const { return current_element_ptr->key; };
+    /* Dereferencing operator */
+    pointer operator->() const { return &current_element_ptr->key; };
+
+    Iterator &operator++()
+    {
+        current_element_ptr = current_element_ptr->nextPtr;
+        if (current_element_ptr == nullptr)
+        {
+            skip();
+        }
+        return *this;
+    };
+
+    Iterator operator++(int)
+    {
+        auto returnCode = *this;
+        ++*this;
+        return returnCode;
+    };
+
+    friend bool operator==(const Iterator &lhs, const Iterator &rhs)
+    {
+        return lhs.current_element_ptr == rhs.current_element_ptr;
+    }
+    friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
+    {
+        return !(lhs.current_element_ptr == rhs.current_element_ptr);
+    }
+};
+
+/* ------- ITERATOR PRIVATE METHODS IMPLEMENTATION ------- */
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage>::Iterator::skip()
+{
+    if (current_element_ptr || index + 1 >= table_size + old_table_size)
+    {
+        return;
+    }
+    // jumps straight to the next non-empty bucket, empty buckets are skipped 64 at a time
+    index = nextOccupied(table_size, occupancy, old_table_size, old_occupancy, index + 1);
+    if (index < table_size)
+    {
+        current_element_ptr = table[index];
+    }
+    else if (index < table_size + old_table_size)
+    {
+        current_element_ptr = old_table[index - table_size];
+    }
+}
+
+/*
+ Non-member-swap() to satisfy the "swappable" concept. Calls lhs.swap(rhs) (see above).
+ lhs: left-hand side rhs: right-hand side. Complexity: O(1)
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void swap(ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs) { lhs.swap(rhs); }
+
+/* ======= OPEN ADDRESSING ======= */
+/*
+Flat storage engine: ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing> (or shorter ADS_flat_set<Key, N>)
 -----------------
-SEPARATE CHAINING
------------------
-author: Hynek Zemanec
------------------
-Conventions:
-* snake_case for member variables
-* camelCase for everything else
------------------
-Specs: https://cewebs.cs.univie.ac.at/algodat/ss22/index.php?m=D&t=info&c=show&CEWebS_what=Spezifikation
+Same public interface as the separate chaining version, but there are no Element nodes:
+the keys are stored directly in one contiguous slot array and every slot has one control byte
+* EMPTY: the slot was never used since the last rehash, a lookup that sees it can stop
+* DELETED: the slot held a key that was erased (tombstone), a lookup has to continue
+* 0..127: the slot is full, the byte holds 7 bits of the hash of its key (tag)
+The slots are split into groups of GROUP_SIZE. A lookup compares the tag of the key with all control bytes of a group
+and only compares the keys of the slots whose tag matches. Groups are probed with triangular numbers (1, 3, 6, ...),
+which visits every group exactly once because the number of groups is a power of two.
+The table grows when more than 7/8 of the slots are full or deleted.
 */
 
-/* ADS_set is a container for elements (a simplification "std::set" and "std::unordered_set")
-Elements are identified by a key. (the entire stored element serves as the key)
+/*
+Control byte helpers of the flat storage engine. All functions look at GROUP_SIZE control bytes
+starting at group and return a bitmask with bit i set if control byte i matches.
+With SSE2 (always available on x86-64) a whole group is compared with one instruction,
+otherwise the group is read as two 64 bit words and compared bytewise in a register (SWAR).
+Define ADS_SET_NO_SIMD to force the portable version.
+*/
+struct ADS_group
+{
+    using ctrl_t = signed char;
+    using mask_t = uint32_t;
 
-insertion of existing values is ignored
-N: the initial size of the hash table */
-template <typename Key, size_t N = 7>
-class ADS_set
+    static constexpr size_t GROUP_SIZE{16};
+    static constexpr ctrl_t EMPTY{-128};
+    static constexpr ctrl_t DELETED{-2};
+
+    static bool isFull(ctrl_t ctrl) { return ctrl >= 0; }
+
+#ifdef ADS_SET_SSE2
+    /* full slots whose tag is tag */
+    static mask_t matchTag(const ctrl_t *group, ctrl_t tag)
+    {
+        __m128i ctrl{_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))};
+        return mask_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl)));
+    }
+
+    /* slots that were never used */
+    static mask_t matchEmpty(const ctrl_t *group)
+    {
+        return matchTag(group, EMPTY);
+    }
+
+    /* slots a new key can be put into (EMPTY and DELETED are the only negative control bytes) */
+    static mask_t matchEmptyOrDeleted(const ctrl_t *group)
+    {
+        return mask_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+    }
+#else
+    static constexpr uint64_t LSBS{0x0101010101010101ULL};
+    static constexpr uint64_t MSBS{0x8080808080808080ULL};
+
+    /* 8 control bytes, byte i of the group in bits 8i..8i+7 */
+    static uint64_t load(const ctrl_t *bytes)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    /* turns the highest bit of every byte of word into one bit of the result */
+    static mask_t compress(uint64_t word)
+    {
+        return mask_t(((word >> 7) * 0x0102040810204080ULL) >> 56);
+    }
+
+    /* applies match (returning the highest bit of every matching byte) to both halves of the group */
+    template <typename Match>
+    static mask_t matchGroup(const ctrl_t *group, Match match)
+    {
+        return compress(match(load(group))) | compress(match(load(group + 8))) << 8;
+    }
+
+    /* full slots whose tag is tag */
+    static mask_t matchTag(const ctrl_t *group, ctrl_t tag)
+    {
+        uint64_t pattern{LSBS * static_cast<unsigned char>(tag)};
+        return matchGroup(group, [pattern](uint64_t word)
+                          {
+                              uint64_t zero_where_equal{word ^ pattern};
+                              // exact zero byte test, bytes never borrow from each other
+                              return ~(((zero_where_equal & ~MSBS) + ~MSBS) | zero_where_equal) & MSBS;
+                          });
+    }
+
+    /* slots that were never used (EMPTY is the only control byte with bit 7 set and bit 1 clear) */
+    static mask_t matchEmpty(const ctrl_t *group)
+    {
+        return matchGroup(group, [](uint64_t word)
+                          { return word & ~(word << 6) & MSBS; });
+    }
+
+    /* slots a new key can be put into (EMPTY and DELETED are the only negative control bytes) */
+    static mask_t matchEmptyOrDeleted(const ctrl_t *group)
+    {
+        return matchGroup(group, [](uint64_t word)
+                          { return word & MSBS; });
+    }
+#endif
+
+    /* index of the lowest set bit, mask must not be 0 */
+    static size_t lowestBit(mask_t mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return size_t(__builtin_ctz(mask));
+#else
+        size_t index{0};
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
+};
+
+template <typename Key, size_t N = 7, typename Hash = ADS_hash<Key>, typename KeyEqual = std::equal_to<>, typename Allocator = std::allocator<Key>>
+using ADS_flat_set = ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>;
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>
 {
 
 public:
     class Iterator;
-    using value_type = Key; // Key is the type of the key
-    using key_type = Key;   // Key is the type of the element
+    using value_type = Key;
+    using key_type = Key;
     using reference = value_type &;
     using const_reference = const value_type &;
-    using size_type = size_t; // the size of something (positive ints)
+    using size_type = size_t;
     using difference_type = std::ptrdiff_t;
     using const_iterator = Iterator;
     using iterator = const_iterator;
-    using key_equal = std::equal_to<key_type>; // comparse hashes
-    using hasher = std::hash<key_type>;        // struct that can hash any data type
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+    using allocator_type = Allocator;
 
 private:
-    /*
-    nextPtr: pointer to the adjecent element (that hashed to the same index)
-    */
-    struct Element
-    {
-        key_type key;
-        Element *nextPtr{nullptr};
-    };
+    template <typename K>
+    using enable_if_transparent = std::enable_if_t<ADS_is_transparent<hasher, key_equal, K>::value>;
 
-    Element **table{nullptr};       // pointer to the array of pointers
-    size_type table_size{0};        // how much room there is
+    using ctrl_t = ADS_group::ctrl_t;
+    using mask_t = ADS_group::mask_t;
+    using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<key_type>;
+    using slot_traits = std::allocator_traits<slot_allocator>;
+    using ctrl_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+    using ctrl_traits = std::allocator_traits<ctrl_allocator>;
+
+    static constexpr size_type GROUP_SIZE{ADS_group::GROUP_SIZE};
+
+    ctrl_t *ctrl{nullptr};          // one control byte per slot
+    key_type *slots{nullptr};       // the keys, only slots with a full control byte hold a constructed key
+    size_type capacity{0};          // number of slots (power of two, multiple of GROUP_SIZE)
     size_type inserted_elements{0}; // how many elements have been inserted
-    float max_load_factor{0.7};     // recommended inserted_elements/table_size
+    size_type growth_left{0};       // how many EMPTY slots may still be filled before the table has to grow
+    float min_load_factor{0};       // erase() shrinks the table below this load factor, 0: never (see shrink_on_erase())
+    size_type fingerprint{0};       // sum of the hash values of all keys, see the separate chaining version
+    ADS_set_counters counters;      // only counted if ADS_SET_STATS is defined (see stats())
+    Allocator allocator;
 
     /*
-    Helper function used in insert() method to add element (key) to the table.
-    Returns pointer to the added element
+    Hash value of the key with its bits mixed (unless the hasher is avalanching already), so that both the group index
+    (high bits) and the tag (low 7 bits) depend on the whole key (std::hash is the identity for integers)
     */
-    Element *add(const key_type &key);
+    template <typename K>
+    static size_type hash(const K &key);
 
-    /*
-    checks if the position is occupied, finds and returns pointer to a searched element based on key_type
-    */
-    Element *locate(const key_type &key) const;
+    /* position in the slot array, or capacity if the key is not stored */
+    template <typename K>
+    size_type locate(const K &key) const
+    {
+        return locate(key, hash(key));
+    }
+
+    /* same as locate(key) for a key whose hash value is already known */
+    template <typename K>
+    size_type locate(const K &key, size_type hash_value) const;
+
+    /* first EMPTY or DELETED slot on the probe sequence of hash_value */
+    size_type findFreeSlot(size_type hash_value) const;
+
+    /* number of keys that are hashed and whose first groups are prefetched together by a batched lookup */
+    static constexpr size_type BULK_BATCH{16};
 
     /*
-    Calculates if the table is large enough to fullfill max load factor 0.7 and enlarges the table and rehashes the values accordingly
+    Looks up the keys of [first, last[ in batches of BULK_BATCH and calls function(slot) for every key in order
+    (slot is capacity if the key is not stored). The first group of every key of a batch is prefetched before
+    the batch is probed. Stops early if function returns false.
     */
-    void reserve(size_type n);
+    template <typename ForwardIt, typename Function>
+    void locateBatch(ForwardIt first, ForwardIt last, Function function) const;
+
+    /* Puts key (which is not stored yet) into the table, returns its slot */
+    template <typename K>
+    size_type add(K &&key, size_type hash_value);
+
+    /* below this many keys per thread buildParallel() does not split the work */
+    static constexpr size_type MIN_KEYS_PER_THREAD{4096};
+
+    /* Fills the empty container with the keys of [first, last[, hashed by threads threads */
+    template <typename RandomIt>
+    void buildParallel(RandomIt first, RandomIt last, unsigned threads);
+
+    /* Implementation of insert(const key_type &) and insert(key_type &&) */
+    template <typename K>
+    std::pair<iterator, bool> insertKey(K &&key);
+
+    /* Implementation of erase(), for key_type and heterogeneous keys */
+    template <typename K>
+    size_type eraseKey(const K &key);
+
+    /* Destroys the key in the full slot index (whose hash value is hash_value) and marks the slot EMPTY or DELETED */
+    void eraseSlot(size_type index, size_type hash_value);
+
+    /* Shrinks the table to half of the load factor once fewer than min_load_factor * capacity keys are left */
+    void shrinkIfSparse()
+    {
+        if (capacity > capacityFor(N) && inserted_elements < capacity * min_load_factor)
+        {
+            rehash(inserted_elements * 2 + inserted_elements / 4);
+        }
+    }
+
+    /* every slot is a bucket for visitBuckets() */
+    size_type bucketCount() const
+    {
+        return capacity;
+    }
+
+    /* Calls function(key) for every key in the slots [first, last[ (see the separate chaining version) */
+    template <typename Function>
+    void visitBuckets(size_type first, size_type last, Function function) const
+    {
+        for (size_type index{first}; index < last; ++index)
+        {
+            if (ADS_group::isFull(ctrl[index]))
+            {
+                function(slots[index]);
+            }
+        }
+    }
+
+    /* Adds a key that is known not to be stored yet */
+    void addUnique(const key_type &key)
+    {
+        add(key, hash(key));
+    }
+
+    friend struct ADS_set_algebra;
+
+    /* Moves all keys into a new table with new_capacity slots (drops all tombstones) */
+    void resize(size_type new_capacity);
+
+    /* Allocates an empty table (all control bytes EMPTY) with new_capacity slots */
+    void allocateTable(size_type new_capacity);
+
+    /* Destroys all keys and frees the table */
+    void destroyTable();
 
     /*
-    Hashing function
+    Table of a container that has not allocated one yet (new, moved from, cleared): one group of EMPTY bytes and storage
+    for as many slots, shared by all such containers (capacity GROUP_SIZE, growth_left 0), so lookups and iterators need
+    no extra check (end() and find() point into the slots, no key is ever constructed there).
+    It is only read; the first insert() (reserve()) replaces it.
     */
-    size_type hash(const key_type &key) const;
+    struct EmptyGroup
+    {
+        ctrl_t bytes[GROUP_SIZE];
+        alignas(key_type) unsigned char slots[GROUP_SIZE * sizeof(key_type)];
+
+        EmptyGroup()
+        {
+            std::fill(bytes, bytes + GROUP_SIZE, ADS_group::EMPTY);
+        }
+    };
+
+    static EmptyGroup &emptyTable()
+    {
+        static EmptyGroup table;
+        return table;
+    }
+
+    static ctrl_t *emptyGroup()
+    {
+        return emptyTable().bytes;
+    }
+
+    static key_type *emptySlots()
+    {
+        return reinterpret_cast<key_type *>(emptyTable().slots);
+    }
+
+    bool ownsTable() const
+    {
+        return ctrl != emptyGroup();
+    }
+
+    /* Number of keys that fit into new_capacity slots */
+    static size_type maxElements(size_type new_capacity)
+    {
+        return new_capacity - new_capacity / 8;
+    }
+
+    /* smallest valid capacity that holds n slots */
+    static size_type capacityFor(size_type n)
+    {
+        size_type new_capacity{GROUP_SIZE};
+        while (new_capacity < n)
+        {
+            new_capacity *= 2;
+        }
+        return new_capacity;
+    }
 
-    /*
-    Rehash all values from the old table to conform to the new table
-    */
-    void rehash(size_type n);
+    /* smallest valid capacity with at least n slots that n elements fit into */
+    static size_type capacityForElements(size_type n)
+    {
+        size_type new_capacity{capacityFor(n)};
+        while (maxElements(new_capacity) < n)
+        {
+            new_capacity *= 2;
+        }
+        return new_capacity;
+    }
 
 public:
     /* ------- CONSTRUCTORS ------- */
 
-    /*
-    Default constructor. empty container (an array) of Element pointers, nullptr by default
-    */
-    ADS_set() : table{new Element *[N] {}}, table_size{N}, inserted_elements{0}
-    {
-        for (size_t index = 0; index < N; ++index)
-        {
-            table[index] = nullptr; // there may be otherwise leftover garbage
-        }
-    };
+    /* Creates an empty container without allocating anything, the first insert() or reserve() allocates the table */
+    ADS_set() noexcept : ADS_set(Allocator{}) {};
+
+    explicit ADS_set(const Allocator &allocator) noexcept : ctrl{emptyGroup()}, slots{emptySlots()}, capacity{GROUP_SIZE}, allocator{allocator} {}
 
-    /*
-    initializer list constructor: Creates a container containing the elements from ilist. The elements are inserted in the order specified in ilist.
-    */
     ADS_set(std::initializer_list<key_type> ilist) : ADS_set{}
     {
         insert(ilist);
     }
 
-    /*
-    Range constructor. Creates a container containing the elements from the range `[first, last]`. The elements are inserted in the given order (starting with first). e.g. first = 1, last = 5 => [1, 2, 3, 4, 5] Complexity: Hashing: O(range_size)
-    */
     template <typename InputIt>
     ADS_set(InputIt first, InputIt last) : ADS_set{}
     {
         insert(first, last);
     }
 
-    /* PH2: copy constructor */
-    ADS_set(const ADS_set &other) : ADS_set{}
+    /*
+    Parallel range constructor (see the separate chaining version). The keys are hashed by threads threads,
+    but placed by the calling thread: a probe sequence may run through the groups of any other thread.
+    */
+    template <typename RandomIt>
+    ADS_set(RandomIt first, RandomIt last, unsigned threads) : ADS_set{}
     {
-        reserve(other.inserted_elements);
-        for (const auto &key : other)
-        {
-            add(key);
-        }
-    };
+        buildParallel(first, last, threads);
+    }
 
     /*
-    PH2: Destructor: The destructors of the stored elements are called and the used memory space is completely freed. Complexity: O(size)
+    Copy constructor. The table has the same layout as the one of other, so the keys are copied slot by slot without hashing them.
     */
-    ~ADS_set()
+    ADS_set(const ADS_set &other)
+        : allocator{std::allocator_traits<Allocator>::select_on_container_copy_construction(other.allocator)}
     {
-        // free up memory from all buckets first
-        for (size_type index{0}; index < table_size; ++index)
+        min_load_factor = other.min_load_factor;
+        if (!other.ownsTable())
         {
-            if (table[index] != nullptr)
+            ctrl = emptyGroup();
+            slots = emptySlots();
+            capacity = GROUP_SIZE;
+            return;
+        }
+        allocateTable(other.capacity);
+        slot_allocator slotAllocator{allocator};
+        size_type index{0};
+        try
+        {
+            for (; index < capacity; ++index)
             {
-                Element *currentElement = table[index];
-                while (currentElement)
+                if (ADS_group::isFull(other.ctrl[index]))
                 {
-                    Element *nextPtr = currentElement->nextPtr;
-                    delete (currentElement);
-                    currentElement = nextPtr;
+                    slot_traits::construct(slotAllocator, slots + index, other.slots[index]);
                 }
-                table[index] = nullptr;
+                ctrl[index] = other.ctrl[index];
             }
         }
-        delete[] table;
-    };
+        catch (...)
+        {
+            // ctrl of the slots not copied yet are still EMPTY, so only the constructed keys are destroyed
+            destroyTable();
+            throw;
+        }
+        inserted_elements = other.inserted_elements;
+        growth_left = other.growth_left;
+        fingerprint = other.fingerprint;
+    }
 
-    /* ------- PUBLIC METHODS ------- */
     /*
-    Inserts the elements from ilist. The elements are inserted in the order specified in ilist. Complexity: O(ilist_size)
+    Move constructor. Takes over the table of other, other is left empty without a table. Complexity: O(1)
     */
+    ADS_set(ADS_set &&other) noexcept : ADS_set(other.allocator)
+    {
+        swap(other);
+    }
+
+    ~ADS_set()
+    {
+        destroyTable();
+    }
+
+    /* ------- PUBLIC METHODS ------- */
+
     void insert(std::initializer_list<key_type> ilist)
     {
-        if (!ilist.size())
-        {
-            return;
-        }
         insert(ilist.begin(), ilist.end());
     }
 
-    /*
-    PH2: Inserts key.
-    Return value: A std::pair consisting of an iterator and a bool.
-    iterator: points to the inserted element if an element was inserted, or to the existing element with the same key if no element was inserted.
-    bool: true if an element was inserted, false otherwise. hashing O(1)  */
     std::pair<iterator, bool> insert(const key_type &key)
     {
-        Element *element{locate(key)};
-        if (element) // element exists?
+        return insertKey(key);
+    }
+
+    std::pair<iterator, bool> insert(key_type &&key)
+    {
+        return insertKey(std::move(key));
+    }
+
+    /*
+    Inserts a key constructed from args. There are no nodes to construct the key in,
+    so it is constructed once and moved into its slot if it is not stored yet.
+    */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args)
+    {
+        key_type key(std::forward<Args>(args)...);
+        return insertKey(std::move(key));
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value)
         {
-            return {iterator{table, element, hash(key), table_size}, false};
+            reserve(inserted_elements + size_type(std::distance(first, last)));
+        }
+        for (auto it{first}; it != last; ++it)
+        {
+            insert(*it);
         }
-
-        // check with load factor condition and insert new element
-        reserve(inserted_elements + 1);
-        return {iterator{table, add(key), hash(key), table_size}, true};
     }
 
     /*
-     Return value: Number of inserted elements that are stored in the container.
+    Inserts the elements from the range [first, last[ without checking if they are already stored.
+    The caller guarantees that the range contains no duplicates and no key that is already in the container.
     */
+    template <typename ForwardIt>
+    void insert_unique_unchecked(ForwardIt first, ForwardIt last)
+    {
+        reserve(inserted_elements + size_type(std::distance(first, last)));
+        for (auto it{first}; it != last; ++it)
+        {
+            add(*it, hash(*it));
+        }
+    }
+
     size_type size() const
     {
         return inserted_elements;
     }
 
-    /*
-    true if size()==0, false otherwise.
-    */
     bool empty() const
     {
         return inserted_elements == 0;
     }
 
+    size_type count(const key_type &key) const
+    {
+        return locate(key) != capacity;
+    }
+
+    template <typename K, typename = enable_if_transparent<K>>
+    size_type count(const K &key) const
+    {
+        return locate(key) != capacity;
+    }
+
     /*
-    Return value: The number of elements in the container with key ( can be either 0 or 1). Complexity: hashing O(1)
+    Batched count() (see the separate chaining version). Return value: out behind the last written count
     */
-    size_type count(const key_type &key) const
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt count_batch(ForwardIt first, ForwardIt last, OutputIt out) const
     {
-        if (locate(key))
-        {
-            return 1;
-        }
-        return 0;
+        locateBatch(first, last, [this, &out](size_type slot)
+                    {
+                        *out++ = size_type(slot != capacity);
+                        return true;
+                    });
+        return out;
     }
 
     /*
-    Inserts the elements from the range [first, last[ in the given order (starting with first).
-    Internally uses add() method. Complexity: Hashing: O(range_size)
+    Batched find(). Return value: out behind the last written iterator
     */
-    template <typename InputIt>
-    void insert(InputIt first, InputIt last);
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) const
+    {
+        locateBatch(first, last, [this, &out](size_type slot)
+                    {
+                        *out++ = iterator{ctrl, slots, slot, capacity};
+                        return true;
+                    });
+        return out;
+    }
 
     /*
-    PH2: Removes all elements from the container. Complexity: O(size)
+    Return value: true if every key of [first, last[ is stored
     */
+    template <typename ForwardIt>
+    bool contains_many(ForwardIt first, ForwardIt last) const
+    {
+        bool contained{true};
+        locateBatch(first, last, [this, &contained](size_type slot)
+                    { return contained = slot != capacity; });
+        return contained;
+    }
+
     void clear()
     {
-        ADS_set temp;
+        ADS_set temp(allocator);
+        temp.min_load_factor = min_load_factor;
+        temp.counters.swap(counters);
         swap(temp);
     }
 
     /*
-    PH2: Removes the element key.
-    Return value: number of deleted elements (0 or 1).
-    For static hash procedures, it is not necessary to reduce an enlarged table again.
+    Removes all elements. With keep_capacity the slot array is kept and only the control bytes are reset to EMPTY.
+    */
+    void clear(bool keep_capacity);
+
+    /*
+    Makes sure n elements fit without exceeding the load factor 7/8, grows the table if necessary
+    */
+    void reserve(size_type n);
+
+    /*
+    Rebuilds the table with at least n slots (more if the stored elements would not fit), drops all tombstones.
+    n smaller than the current capacity shrinks the table.
+    */
+    void rehash(size_type n)
+    {
+        resize(std::max(capacityFor(N), capacityForElements(std::max(n, inserted_elements))));
+    }
+
+    /*
+    Shrinks the table to the smallest capacity that holds the stored elements
+    */
+    void shrink_to_fit()
+    {
+        rehash(0);
+    }
+
+    /*
+    Lets erase() shrink the table once fewer than min_load_factor * capacity elements are stored (0 turns it off, default).
+    Limited to a quarter of the load factor 7/8 like the separate chaining version.
     */
+    void shrink_on_erase(float min_load_factor)
+    {
+        this->min_load_factor = std::max(0.0f, std::min(min_load_factor, 7.0f / 32));
+    }
+
     size_type erase(const key_type &key)
     {
-        Element *elementPtr{table[hash(key)]};
-        Element *auxElementPtr{nullptr};
+        return eraseKey(key);
+    }
 
-        while (elementPtr)
-        {
-            if (key_equal{}(elementPtr->key, key))
-            {
-                if (auxElementPtr)
-                {
-                    auxElementPtr->nextPtr = elementPtr->nextPtr;
-                }
-                else
-                {
-                    table[hash(key)] = elementPtr->nextPtr;
-                }
+    template <typename K, typename = enable_if_transparent<K>>
+    size_type erase(const K &key)
+    {
+        return eraseKey(key);
+    }
 
-                delete elementPtr;
-                --inserted_elements;
+    /*
+    Moves every key of source that is not stored in this container yet into this container (see the separate chaining version)
+    */
+    void merge(ADS_set &source);
 
-                return 1;
-            }
-            auxElementPtr = elementPtr;
-            elementPtr = auxElementPtr->nextPtr;
-        }
-        return 0;
+    void merge(ADS_set &&source)
+    {
+        merge(source);
     }
 
     /*
-    PH2: Return value: an iterator on the element with the key, or the end iterator (see end()) if no such element exists.
-    Complexity: hashing O(1)
+    Removes every key for which predicate(key) is true. Return value: number of removed keys.
     */
-    iterator find(const key_type &key) const
+    template <typename Predicate>
+    size_type erase_if(Predicate predicate)
     {
-        if (Element * element{locate(key)})
+        size_type erased{0};
+        for (size_type index{0}; index < capacity; ++index)
+        {
+            if (ADS_group::isFull(ctrl[index]) && predicate(static_cast<const key_type &>(slots[index])))
+            {
+                eraseSlot(index, hash(slots[index]));
+                ++erased;
+            }
+        }
+        if (erased)
         {
-            return iterator{table, element, hash(key), table_size};
+            shrinkIfSparse();
         }
-        return end();
+        return erased;
+    }
+
+    iterator find(const key_type &key) const
+    {
+        return iterator{ctrl, slots, locate(key), capacity};
+    }
+
+    template <typename K, typename = enable_if_transparent<K>>
+    iterator find(const K &key) const
+    {
+        return iterator{ctrl, slots, locate(key), capacity};
     }
 
-    /*
-    PH2: Swaps the elements of the container with the elements of the container other.Complexity: O(1)
-    */
     void swap(ADS_set &other)
     {
-        std::swap(table, other.table);
+        std::swap(ctrl, other.ctrl);
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
         std::swap(inserted_elements, other.inserted_elements);
-        std::swap(table_size, other.table_size);
-        std::swap(max_load_factor, other.max_load_factor);
+        std::swap(growth_left, other.growth_left);
+        std::swap(min_load_factor, other.min_load_factor);
+        std::swap(fingerprint, other.fingerprint);
+        counters.swap(other.counters);
+        std::swap(allocator, other.allocator);
+    }
+
+    allocator_type get_allocator() const
+    {
+        return allocator;
     }
 
-    /*
-    PH2: Return value: Iterator on the first element or the end iterator if the container is empty.
-    */
     const_iterator begin() const
     {
-        return const_iterator(table, table[0], 0, table_size);
+        return const_iterator{ctrl, slots, 0, capacity};
     }
 
-    /*
-    PH2: Returns an iterator to the (virtual) element after the last element in the container ("end iterator").
-    Return value: End iterator
-    */
     const_iterator end() const
     {
-        return const_iterator(table, nullptr, table_size, table_size);
+        return const_iterator{ctrl, slots, capacity, capacity};
     }
 
+    void dump(std::ostream &o = std::cerr, ADS_dump mode = ADS_dump::full) const;
+
     /*
-    Output the container contents to the stream o. There is no default for the functionality of dump(), i.e. it is not prescribed what the method writes to the stream. It is also permissible for the method to output nothing. However, it is recommended to output at least all contained elements. With testing it can be helpful beyond that, if the output represents in some form also the condition of the data structure.
-    The unit test outputs the contents of the container with the help of this method in the event of errors, in order to facilitate troubleshooting. However, if the output is overly large, the unit test may truncate it. It may be assumed that the container is instantiated during unit testing only with element data types (key_type) that support the output operator (<<).
+    Return value: see ADS_set_stats, a chain is the probe sequence of a key here. Complexity: O(capacity), every key is hashed once
     */
-    void dump(std::ostream &o = std::cerr) const;
+    ADS_set_stats stats() const;
 
     /* ------- OPERATORS ------- */
 
-    /*
-    PH2: Checks if the contents of two containers are equal. The contents are equal if the containers are of the same size and for each element in lhs there is an element in rhs with the same key. Return value: true if the container contents are equal, false otherwise. Complexity: O(size).
-    */
     friend bool operator==(const ADS_set &lhs, const ADS_set &rhs)
     {
-        // same number of inserted elements?
-        if (lhs.inserted_elements != rhs.inserted_elements)
+        if (lhs.inserted_elements != rhs.inserted_elements || lhs.fingerprint != rhs.fingerprint)
         {
             return false;
         }
         for (const auto &key : lhs)
         {
-            if (rhs.locate(key) == nullptr)
-            {
-                return false;
-            }
+            if (rhs.locate(key) == rhs.capacity)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const ADS_set &lhs, const ADS_set &rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    ADS_set &operator=(const ADS_set &other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        ADS_set temporary{other};
+        swap(temporary);
+        return *this;
+    }
+
+    ADS_set &operator=(ADS_set &&other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        ADS_set temporary{std::move(other)};
+        swap(temporary);
+        return *this;
+    }
+
+    ADS_set &operator=(std::initializer_list<key_type> ilist)
+    {
+        ADS_set temporary{ilist};
+        swap(temporary);
+        return *this;
+    }
+};
+
+/* ------- OPEN ADDRESSING PRIVATE METHODS IMPLEMENTATION ------- */
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::hash(const K &key)
+{
+    if constexpr (ADS_is_avalanching<hasher>::value)
+    {
+        return hasher{}(key);
+    }
+    else
+    {
+        return ADS_mix(hasher{}(key));
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::locate(const K &key, size_type hash_value) const
+{
+    ctrl_t tag{ctrl_t(hash_value & 0x7F)};
+    size_type group_mask{capacity / GROUP_SIZE - 1};
+    size_type group{(hash_value >> 7) & group_mask};
+
+    size_type step{1};
+    for (; step <= group_mask + 1; ++step)
+    {
+        size_type group_start{group * GROUP_SIZE};
+        for (mask_t match{ADS_group::matchTag(ctrl + group_start, tag)}; match; match &= match - 1)
+        {
+            size_type index{group_start + ADS_group::lowestBit(match)};
+            if (key_equal{}(slots[index], key))
+            {
+                counters.countLookup(step);
+                return index;
+            }
+        }
+        // the key would have been put into this group if it was inserted
+        if (ADS_group::matchEmpty(ctrl + group_start))
+        {
+            break;
+        }
+        group = (group + step) & group_mask;
+    }
+    counters.countLookup(std::min(step, group_mask + 1));
+    return capacity; // the key not found
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename ForwardIt, typename Function>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::locateBatch(ForwardIt first, ForwardIt last, Function function) const
+{
+    ForwardIt keys[BULK_BATCH];
+    size_type hashes[BULK_BATCH];
+    const size_type group_mask{capacity / GROUP_SIZE - 1};
+
+    while (first != last)
+    {
+        // 1. hash the batch and request the control bytes and slots of the first group of every key
+        size_type batch_size{0};
+        for (; first != last && batch_size < BULK_BATCH; ++first, ++batch_size)
+        {
+            keys[batch_size] = first;
+            hashes[batch_size] = hash(*first);
+            size_type group_start{((hashes[batch_size] >> 7) & group_mask) * GROUP_SIZE};
+            ADS_prefetch(ctrl + group_start);
+            ADS_prefetch(slots + group_start);
+        }
+
+        // 2. probe, the groups are (hopefully) in the cache by now
+        for (size_type index{0}; index < batch_size; ++index)
+        {
+            if (!function(locate(*keys[index], hashes[index])))
+            {
+                return;
+            }
+        }
+    }
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::findFreeSlot(size_type hash_value) const
+{
+    size_type group_mask{capacity / GROUP_SIZE - 1};
+    size_type group{(hash_value >> 7) & group_mask};
+
+    // there always is a free slot, the table never gets completely full
+    for (size_type step{1};; ++step)
+    {
+        size_type group_start{group * GROUP_SIZE};
+        if (mask_t free{ADS_group::matchEmptyOrDeleted(ctrl + group_start)})
+        {
+            return group_start + ADS_group::lowestBit(free);
         }
-        return true;
+        group = (group + step) & group_mask;
     }
+}
 
-    /*
-    PH2: Checks if the contents of two containers are not equal.
-    Return value: false if the container contents are equal, true otherwise. Complexity: O(size).
-    */
-    friend bool operator!=(const ADS_set &lhs, const ADS_set &rhs)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::iterator, bool> ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::insertKey(K &&key)
+{
+    size_type hash_value{hash(key)};
+    size_type index{locate(key, hash_value)};
+    if (index != capacity) // element exists?
     {
-        return !(lhs == rhs);
+        return {iterator{ctrl, slots, index, capacity}, false};
     }
 
-    /*
-    PH2: Overload of Assignment Operator, Copy assignment operator -> The contents of the container will be replaced by the contents of other
-    */
-    ADS_set &operator=(const ADS_set &other)
+    index = add(std::forward<K>(key), hash_value);
+    return {iterator{ctrl, slots, index, capacity}, true};
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename RandomIt>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::buildParallel(RandomIt first, RandomIt last, unsigned threads)
+{
+    const size_type key_count{size_type(last - first)};
+    if (threads <= 1 || key_count / threads < MIN_KEYS_PER_THREAD)
     {
-        // don't swap if the contents are the same
-        if (this == &other)
+        insert(first, last);
+        return;
+    }
+    std::vector<size_type> hashes(key_count);
+    ADS_parallel(threads, [&](unsigned slice)
+                 {
+                     for (size_type index{key_count * slice / threads}; index < key_count * (slice + 1) / threads; ++index)
+                     {
+                         hashes[index] = hash(first[std::ptrdiff_t(index)]);
+                     }
+                 });
+    reserve(key_count);
+    for (size_type index{0}; index < key_count; ++index)
+    {
+        const key_type &key{first[std::ptrdiff_t(index)]};
+        if (locate(key, hashes[index]) == capacity)
         {
-            return *this;
+            add(key, hashes[index]);
         }
-
-        ADS_set temporary{other};
-        swap(temporary);
-        return *this;
     }
+}
 
-    /*
-    PH2: Copy assignment operator. The contents of the container will be replaced by the contents of other. Return value: reference to *this  Complexity: hashing: O(size + other_size)
-    */
-    ADS_set &operator=(std::initializer_list<key_type> ilist)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::add(K &&key, size_type hash_value)
+{
+    size_type index{findFreeSlot(hash_value)};
+    // reusing a tombstone does not use up an EMPTY slot, so only then the table may have to grow
+    if (ctrl[index] == ADS_group::EMPTY && growth_left == 0)
     {
-        ADS_set temporary{ilist};
-        swap(temporary);
-        return *this;
+        reserve(inserted_elements + 1);
+        index = findFreeSlot(hash_value);
     }
-};
 
-/* ------- CONTAINER PRIVATE METHODS IMPLEMENTATION ------- */
-template <typename Key, size_t N>
-template <typename InputIt>
-void ADS_set<Key, N>::insert(InputIt first, InputIt last)
-{
-    for (auto it{first}; it != last; ++it)
+    slot_allocator slotAllocator{allocator};
+    slot_traits::construct(slotAllocator, slots + index, std::forward<K>(key));
+    if (ctrl[index] == ADS_group::EMPTY)
     {
-        if (count(*it) == 0) // if el not found
-        {
-            reserve(inserted_elements + 1);
-            add(*it);
-        }
+        --growth_left;
     }
+    ctrl[index] = ctrl_t(hash_value & 0x7F);
+    ++inserted_elements;
+    fingerprint += hash_value;
+
+    return index;
 }
 
-template <typename Key, size_t N>
-typename ADS_set<Key, N>::size_type ADS_set<Key, N>::hash(const key_type &key) const
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::size_type ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::eraseKey(const K &key)
 {
-    return hasher{}(key) % table_size;
+    size_type hash_value{hash(key)};
+    size_type index{locate(key, hash_value)};
+    if (index == capacity)
+    {
+        return 0;
+    }
+    eraseSlot(index, hash_value);
+    shrinkIfSparse();
+    return 1;
 }
 
-template <typename Key, size_t N>
-typename ADS_set<Key, N>::Element *ADS_set<Key, N>::add(const key_type &key)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::eraseSlot(size_type index, size_type hash_value)
 {
-    size_type index{hash(key)};
+    slot_allocator slotAllocator{allocator};
+    slot_traits::destroy(slotAllocator, slots + index);
+    --inserted_elements;
+    fingerprint -= hash_value;
 
-    if (table[index])
+    // a lookup stops in a group with an EMPTY slot anyway, so the slot can become EMPTY again instead of a tombstone
+    size_type group_start{index / GROUP_SIZE * GROUP_SIZE};
+    if (ADS_group::matchEmpty(ctrl + group_start))
     {
-        Element *old_element = table[index];
-        Element *new_element = new Element{key, old_element};
-        table[index] = new_element;
+        ctrl[index] = ADS_group::EMPTY;
+        ++growth_left;
     }
     else
     {
-        table[index] = new Element{key, nullptr};
+        ctrl[index] = ADS_group::DELETED;
     }
-    ++inserted_elements;
-
-    return table[index];
 }
 
-template <typename Key, size_t N>
-typename ADS_set<Key, N>::Element *ADS_set<Key, N>::locate(const key_type &key) const
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::merge(ADS_set &source)
 {
-    Element *currentElementPtr = table[hash(key)];
-
-    while (currentElementPtr)
+    if (&source == this)
+    {
+        return;
+    }
+    reserve(inserted_elements + source.inserted_elements);
+    for (size_type index{0}; index < source.capacity; ++index)
     {
-        if (key_equal{}(currentElementPtr->key, key))
+        if (!ADS_group::isFull(source.ctrl[index]))
         {
-            // return it if exists
-            return currentElementPtr;
+            continue;
+        }
+        size_type hash_value{hash(source.slots[index])};
+        if (locate(source.slots[index], hash_value) == capacity)
+        {
+            add(std::move_if_noexcept(source.slots[index]), hash_value);
+            source.eraseSlot(index, hash_value);
         }
-        currentElementPtr = currentElementPtr->nextPtr;
     }
-    return nullptr; // the key not found
 }
 
-template <typename Key, size_t N>
-void ADS_set<Key, N>::reserve(size_type n)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::reserve(size_type n)
 {
-    if ((table_size * max_load_factor) >= n)
+    if (inserted_elements + growth_left >= n)
     {
         return;
     }
 
-    size_type new_table_size{table_size};
-
-    while (new_table_size * max_load_factor < n)
+    size_type new_capacity{ownsTable() ? capacity : capacityFor(N)};
+    while (maxElements(new_capacity) < n)
     {
-        ++(new_table_size *= 2); // to make sure we don't start from 0 because 0 * 2 = 0
+        new_capacity *= 2;
     }
-    rehash(new_table_size);
+    // growth_left is used up by tombstones as well: a table that is mostly tombstones is only cleaned up, otherwise it grows
+    if (ownsTable() && new_capacity == capacity && n > maxElements(capacity) / 2)
+    {
+        new_capacity *= 2;
+    }
+    resize(new_capacity);
 }
 
-template <typename Key, size_t N>
-void ADS_set<Key, N>::rehash(size_type n)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::allocateTable(size_type new_capacity)
 {
-    size_type new_table_size{
-        std::max(N,
-                 std::max(n,
-                          size_type(
-                              inserted_elements / max_load_factor)))};
-
-    Element **new_table{new Element *[new_table_size] {}};
-    Element **old_table{table};
-    size_type old_table_size{table_size};
+    ctrl_allocator ctrlAllocator{allocator};
+    slot_allocator slotAllocator{allocator};
 
+    ctrl_t *new_ctrl{ctrl_traits::allocate(ctrlAllocator, new_capacity)};
+    try
+    {
+        slots = slot_traits::allocate(slotAllocator, new_capacity);
+    }
+    catch (...)
+    {
+        ctrl_traits::deallocate(ctrlAllocator, new_ctrl, new_capacity);
+        throw;
+    }
+    ctrl = new_ctrl;
+    std::fill(ctrl, ctrl + new_capacity, ADS_group::EMPTY);
+    capacity = new_capacity;
     inserted_elements = 0;
-    table = new_table;
-    table_size = new_table_size;
+    growth_left = maxElements(new_capacity);
+}
 
-    for (size_type index{0}; index < old_table_size; ++index)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::destroyTable()
+{
+    if (!ctrl || !ownsTable())
+    {
+        return;
+    }
+    slot_allocator slotAllocator{allocator};
+    ctrl_allocator ctrlAllocator{allocator};
+    if (!std::is_trivially_destructible<key_type>::value)
     {
-        // if slot in the old table is occupied add the key to the new table
-        if (old_table[index])
+        for (size_type index{0}; index < capacity; ++index)
         {
-            // loop over old linked list
-            Element *currentElementPtr = old_table[index];
-            while (currentElementPtr)
+            if (ADS_group::isFull(ctrl[index]))
             {
-                add(currentElementPtr->key);
-                // to prevenet memory leak
-                Element *auxPtr = currentElementPtr;
-                currentElementPtr = auxPtr->nextPtr;
-                delete auxPtr;
+                slot_traits::destroy(slotAllocator, slots + index);
             }
         }
     }
-    delete[] old_table; // not needed anymore
+    slot_traits::deallocate(slotAllocator, slots, capacity);
+    ctrl_traits::deallocate(ctrlAllocator, ctrl, capacity);
+    ctrl = nullptr;
+    slots = nullptr;
 }
 
-template <typename Key, size_t N>
-void ADS_set<Key, N>::dump(std::ostream &o) const
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::resize(size_type new_capacity)
 {
-    Element *current_element_ptr;
+    if (!ownsTable())
+    {
+        // the first table of the container, there is nothing to move
+        allocateTable(new_capacity);
+        return;
+    }
+    auto start{counters.startTimer()};
+    counters.countRehash();
+    ctrl_t *old_ctrl{ctrl};
+    key_type *old_slots{slots};
+    size_type old_capacity{capacity};
+    size_type old_inserted_elements{inserted_elements};
 
-    o << "table_size = " << table_size << ", inserted_elements = " << inserted_elements << "\n";
-    for (size_type index{0}; index < table_size; ++index)
+    allocateTable(new_capacity);
+
+    slot_allocator slotAllocator{allocator};
+    for (size_type old_index{0}; old_index < old_capacity; ++old_index)
     {
-        o << index << ": ";
-        if (table[index] == nullptr)
+        if (!ADS_group::isFull(old_ctrl[old_index]))
         {
-            o << "--FREE \n";
             continue;
         }
+        size_type hash_value{hash(old_slots[old_index])};
+        size_type index{findFreeSlot(hash_value)};
+        slot_traits::construct(slotAllocator, slots + index, std::move_if_noexcept(old_slots[old_index]));
+        slot_traits::destroy(slotAllocator, old_slots + old_index);
+        ctrl[index] = ctrl_t(hash_value & 0x7F);
+    }
+    inserted_elements = old_inserted_elements;
+    growth_left -= inserted_elements;
 
-        o << "[";
-
-        current_element_ptr = table[index];
+    slot_traits::deallocate(slotAllocator, old_slots, old_capacity);
+    ctrl_allocator ctrlAllocator{allocator};
+    ctrl_traits::deallocate(ctrlAllocator, old_ctrl, old_capacity);
+    counters.stopTimer(start);
+}
 
-        while (current_element_ptr)
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::clear(bool keep_capacity)
+{
+    if (!keep_capacity)
+    {
+        clear();
+        return;
+    }
+    if (!std::is_trivially_destructible<key_type>::value)
+    {
+        slot_allocator slotAllocator{allocator};
+        for (size_type index{0}; index < capacity; ++index)
         {
-            o << current_element_ptr->key;
-            current_element_ptr = current_element_ptr->nextPtr;
-            if (current_element_ptr)
+            if (ADS_group::isFull(ctrl[index]))
             {
-                o << " -> ";
+                slot_traits::destroy(slotAllocator, slots + index);
             }
         }
-        o << "]\n";
+    }
+    if (!ownsTable())
+    {
+        return;
+    }
+    std::fill(ctrl, ctrl + capacity, ADS_group::EMPTY);
+    inserted_elements = 0;
+    fingerprint = 0;
+    growth_left = maxElements(capacity);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+ADS_set_stats ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::stats() const
+{
+    ADS_set_stats stats;
+    stats.size = inserted_elements;
+    stats.bucket_count = capacity;
+    stats.load_factor = double(inserted_elements) / double(capacity);
+    stats.empty_bucket_ratio = double(capacity - inserted_elements) / double(capacity);
+    const size_type group_mask{capacity / GROUP_SIZE - 1};
+    for (size_type index{0}; index < capacity; ++index)
+    {
+        if (!ADS_group::isFull(ctrl[index]))
+        {
+            continue;
+        }
+        // groups on the probe sequence up to the one the key is stored in
+        size_type length{1};
+        for (size_type group{(hash(slots[index]) >> 7) & group_mask}; group != index / GROUP_SIZE; ++length)
+        {
+            group = (group + length) & group_mask;
+        }
+        if (length >= stats.chain_lengths.size())
+        {
+            stats.chain_lengths.resize(length + 1);
+        }
+        ++stats.chain_lengths[length];
+        stats.max_chain = std::max(stats.max_chain, length);
+    }
+    stats.bytes = ownsTable() ? capacity * (sizeof(ctrl_t) + sizeof(key_type)) : 0;
+    counters.fill(stats);
+    return stats;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::dump(std::ostream &o, ADS_dump mode) const
+{
+    if (mode == ADS_dump::summary)
+    {
+        o << stats();
+        return;
+    }
+    o << "capacity = " << capacity << ", inserted_elements = " << inserted_elements << ", growth_left = " << growth_left << "\n";
+    for (size_type index{0}; index < capacity; ++index)
+    {
+        o << index << ": ";
+        if (ctrl[index] == ADS_group::EMPTY)
+        {
+            o << "--FREE \n";
+        }
+        else if (ctrl[index] == ADS_group::DELETED)
+        {
+            o << "--DELETED \n";
+        }
+        else
+        {
+            o << "[" << slots[index] << "]\n";
+        }
     }
     o << "\n";
 }
 
-/* ------- ITERATOR ------- */
+/* ------- OPEN ADDRESSING ITERATOR ------- */
 /*
- PH2 Iterator must implement:
- 1. at which element I am in the data structure
- 2. how do I get to the next one
- 3. how do I recognize the "end"
- */
-template <typename Key, size_t N>
-class ADS_set<Key, N>::Iterator
+Walks the control bytes and stops at every full slot
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Allocator, ADS_open_addressing>::Iterator
 {
 private:
-    Element **table;
-    Element *current_element_ptr;
-    size_type index;
-    size_type table_size;
+    const ctrl_t *ctrl_ptr;
+    const ctrl_t *ctrl_end;
+    const key_type *slot_ptr;
 
-    /* goes through all the elements and skips empty slots */
-    void skip();
+    /* moves on to the next full slot (or the end) */
+    void skip()
+    {
+        while (ctrl_ptr != ctrl_end && !ADS_group::isFull(*ctrl_ptr))
+        {
+            ++ctrl_ptr;
+            ++slot_ptr;
+        }
+    }
 
 public:
     using value_type = Key;
@@ -532,28 +4077,23 @@ public:
     using pointer = const value_type *;
     using iterator_category = std::forward_iterator_tag;
 
-    /* default constructor that performs no conversions is required */
-    explicit Iterator(Element **table = nullptr,
-                      Element *current_element_ptr = nullptr,
+    explicit Iterator(const ctrl_t *ctrl = nullptr,
+                      const key_type *slots = nullptr,
                       size_type index = 0,
-                      size_type table_size = 0)
-        : table{table}, current_element_ptr{current_element_ptr}, index{index}, table_size{table_size}
+                      size_type capacity = 0)
+        : ctrl_ptr{ctrl + index}, ctrl_end{ctrl + capacity}, slot_ptr{slots + index}
     {
-        skip(); // do while current position
+        skip();
     };
 
-    /* Pointer generalization */
-    reference operator*() const { return current_element_ptr->key; };
-    /* Dereferencing operator */
-    pointer operator->() const { return &current_element_ptr->key; };
+    reference operator*() const { return *slot_ptr; };
+    pointer operator->() const { return slot_ptr; };
 
     Iterator &operator++()
     {
-        current_element_ptr = current_element_ptr->nextPtr;
-        if (current_element_ptr == nullptr)
-        {
-            skip();
-        }
+        ++ctrl_ptr;
+        ++slot_ptr;
+        skip();
         return *this;
     };
 
@@ -566,29 +4106,223 @@ public:
 
     friend bool operator==(const Iterator &lhs, const Iterator &rhs)
     {
-        return lhs.current_element_ptr == rhs.current_element_ptr;
+        return lhs.slot_ptr == rhs.slot_ptr;
     }
     friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
     {
-        return !(lhs.current_element_ptr == rhs.current_element_ptr);
+        return !(lhs.slot_ptr == rhs.slot_ptr);
     }
 };
 
-/* ------- ITERATOR PRIVATE METHODS IMPLEMENTATION ------- */
-template <typename Key, size_t N>
-void ADS_set<Key, N>::Iterator::skip()
+/* moves only swap pointers (containers of ADS_sets move their elements instead of copying them) */
+static_assert(std::is_nothrow_move_constructible<ADS_set<int>>::value && std::is_nothrow_move_assignable<ADS_set<int>>::value,
+              "ADS_set: move has to be noexcept");
+static_assert(std::is_nothrow_move_constructible<ADS_flat_set<int>>::value && std::is_nothrow_move_assignable<ADS_flat_set<int>>::value,
+              "ADS_flat_set: move has to be noexcept");
+
+
+/* ======= SET ALGEBRA ======= */
+/*
+set_union(), set_intersection(), set_difference() and is_subset() for two ADS_sets of the same type (both storage engines)
+-----------------
+* the smaller container is iterated and the keys are looked up in the larger one
+* the result is reserved once for the largest possible number of keys and keys are added without a duplicate check
+* an rvalue operand is reused as the result: its nodes (or slots) are kept and only the keys that do not belong
+  to the result are erased (set_union() inserts the smaller operand into the larger one)
+* set_intersection() and set_difference() of two lvalues can look up the keys with threads threads:
+  the iterated container is split into bucket ranges and every thread collects the matching keys of its range,
+  the result is then filled by the calling thread
+*/
+struct ADS_set_algebra
+{
+    /* below this many buckets per thread the work is not split */
+    static constexpr size_t MIN_BUCKETS_PER_THREAD{4096};
+
+    /*
+    New container with all keys of source for which predicate(key) is true, expected: upper bound of the result size.
+    predicate is called from threads threads at the same time, it must only read.
+    */
+    template <typename Set, typename Predicate>
+    static Set filter(const Set &source, Predicate predicate, size_t expected, unsigned threads)
+    {
+        using key_type = typename Set::key_type;
+
+        Set result(source.get_allocator());
+        result.reserve(expected);
+        const size_t buckets{source.bucketCount()};
+        if (threads <= 1 || buckets / threads < MIN_BUCKETS_PER_THREAD)
+        {
+            source.visitBuckets(0, buckets, [&](const key_type &key)
+                                {
+                                    if (predicate(key))
+                                    {
+                                        result.addUnique(key);
+                                    }
+                                });
+            return result;
+        }
+
+        std::vector<std::vector<const key_type *>> matches(threads);
+        ADS_parallel(threads, [&](unsigned part)
+                     {
+                         source.visitBuckets(buckets * part / threads, buckets * (part + 1) / threads, [&](const key_type &key)
+                                             {
+                                                 if (predicate(key))
+                                                 {
+                                                     matches[part].push_back(&key);
+                                                 }
+                                             });
+                     });
+        for (const std::vector<const key_type *> &part_matches : matches)
+        {
+            for (const key_type *key : part_matches)
+            {
+                result.addUnique(*key);
+            }
+        }
+        return result;
+    }
+};
+
+/*
+Return value: container with the keys that are stored in lhs or rhs
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_union(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs)
+{
+    const bool lhs_larger{lhs.size() >= rhs.size()};
+    ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> result{lhs_larger ? lhs : rhs};
+    const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &smaller{lhs_larger ? rhs : lhs};
+    result.insert(smaller.begin(), smaller.end());
+    return result;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_union(ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs)
+{
+    ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> result{std::move(lhs)};
+    result.insert(rhs.begin(), rhs.end());
+    return result;
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_union(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&rhs)
+{
+    return set_union(std::move(rhs), lhs);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_union(ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&lhs, ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&rhs)
 {
-    while (!current_element_ptr && (index + 1 < table_size))
+    if (lhs.size() < rhs.size())
     {
-        current_element_ptr = table[++index];
+        lhs.swap(rhs);
     }
+    ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> result{std::move(lhs)};
+    result.merge(rhs);
+    return result;
 }
 
 /*
- Non-member-swap() to satisfy the "swappable" concept. Calls lhs.swap(rhs) (see above).
- lhs: left-hand side rhs: right-hand side. Complexity: O(1)
+Return value: container with the keys that are stored in lhs and rhs
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_intersection(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs, unsigned threads = 1)
+{
+    const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &smaller{lhs.size() <= rhs.size() ? lhs : rhs};
+    const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &larger{lhs.size() <= rhs.size() ? rhs : lhs};
+    return ADS_set_algebra::filter(
+        smaller, [&larger](const Key &key)
+        { return larger.count(key) != 0; },
+        smaller.size(), threads);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_intersection(ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs)
+{
+    if (rhs.size() < lhs.size())
+    {
+        return set_intersection(static_cast<const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &>(lhs), rhs);
+    }
+    lhs.erase_if([&rhs](const Key &key)
+                 { return rhs.count(key) == 0; });
+    return std::move(lhs);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_intersection(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&rhs)
+{
+    return set_intersection(std::move(rhs), lhs);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_intersection(ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&lhs, ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&rhs)
+{
+    if (rhs.size() < lhs.size())
+    {
+        lhs.swap(rhs);
+    }
+    return set_intersection(std::move(lhs), static_cast<const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &>(rhs));
+}
+
+/*
+Return value: container with the keys of lhs that are not stored in rhs.
+If rhs is the smaller one, lhs is copied and the keys of rhs are erased from the copy.
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_difference(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs, unsigned threads = 1)
+{
+    if (rhs.size() < lhs.size())
+    {
+        ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> result{lhs};
+        for (const auto &key : rhs)
+        {
+            result.erase(key);
+        }
+        return result;
+    }
+    return ADS_set_algebra::filter(
+        lhs, [&rhs](const Key &key)
+        { return rhs.count(key) == 0; },
+        lhs.size(), threads);
+}
+
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> set_difference(ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &&lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs)
+{
+    if (rhs.size() < lhs.size())
+    {
+        for (const auto &key : rhs)
+        {
+            lhs.erase(key);
+        }
+    }
+    else
+    {
+        lhs.erase_if([&rhs](const Key &key)
+                     { return rhs.count(key) != 0; });
+    }
+    return std::move(lhs);
+}
+
+/*
+Return value: true if every key of lhs is stored in rhs. Stops at the first key that is not.
 */
-template <typename Key, size_t N>
-void swap(ADS_set<Key, N> &lhs, ADS_set<Key, N> &rhs) { lhs.swap(rhs); }
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+bool is_subset(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &lhs, const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &rhs)
+{
+    if (lhs.size() > rhs.size())
+    {
+        return false;
+    }
+    for (const auto &key : lhs)
+    {
+        if (!rhs.count(key))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
 #endif // ADS_SET_H
\ No newline at end of file
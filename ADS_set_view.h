@@ -0,0 +1,437 @@
+// macros
+#ifndef ADS_SET_VIEW_H
+#define ADS_SET_VIEW_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ADS_SET_VIEW_MMAP
+#endif
+
+#include "ADS_set.h"
+
+/*
+-----------------
+BINARY SNAPSHOTS
+-----------------
+write_snapshot() stores the keys of an ADS_set (keys must be trivially copyable) in a file that ADS_set_view
+serves count(), find() and iteration from without deserialising anything.
+File layout (native byte order, checked on open):
+* ADS_snapshot_header
+* bucket_count + 1 offsets (uint64_t): the keys of bucket b are keys[offsets[b]] .. keys[offsets[b + 1] - 1]
+* the keys, sorted by bucket, starting at keys_offset
+The file is mapped read only (mmap), so pages are only loaded when a lookup touches them and all processes
+that open the same snapshot share the physical pages. Without mmap (not a POSIX system) the file is read into memory.
+The bucket of a key depends on its hash value, so the view has to use the same Hash as the program that wrote the snapshot.
+-----------------
+*/
+struct ADS_snapshot_header
+{
+    static constexpr char MAGIC[8]{'A', 'D', 'S', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr uint32_t VERSION{1};
+    static constexpr uint32_t BYTE_ORDER_MARK{0x01020304}; // reads differently if the file was written with another byte order
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t key_size;      // sizeof(Key) of the writer
+    uint64_t bucket_count;  // power of two
+    uint64_t element_count; // number of keys
+    uint64_t keys_offset;   // position of the first key from the start of the file
+    uint64_t checksum;      // of everything after the header (see ADS_snapshot_checksum())
+};
+
+/*
+Checksum of size bytes: the bytes are read as 64 bit words, every word is mixed into the running value
+*/
+inline uint64_t ADS_snapshot_checksum(const unsigned char *data, size_t size)
+{
+    uint64_t checksum{size};
+    uint64_t word;
+    for (; size >= sizeof(word); data += sizeof(word), size -= sizeof(word))
+    {
+        std::memcpy(&word, data, sizeof(word));
+        checksum = ADS_mix(checksum ^ word);
+    }
+    word = 0;
+    std::memcpy(&word, data, size);
+    return ADS_mix(checksum ^ word);
+}
+
+/*
+Read only set of keys served directly from a snapshot file
+Key: trivially copyable key type, Hash and KeyEqual: the same as the ones of the ADS_set the snapshot was written from
+*/
+template <typename Key, typename Hash = ADS_hash<Key>, typename KeyEqual = std::equal_to<>>
+class ADS_set_view
+{
+public:
+    using value_type = Key;
+    using key_type = Key;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = const key_type *; // the keys are one contiguous array
+    using iterator = const_iterator;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+
+    static_assert(std::is_trivially_copyable<key_type>::value, "snapshots can only hold trivially copyable keys");
+
+private:
+    const unsigned char *data{nullptr}; // the whole file
+    size_type data_size{0};
+    const ADS_snapshot_header *header{nullptr};
+    const uint64_t *offsets{nullptr};
+    const key_type *keys{nullptr};
+    std::unique_ptr<uint64_t[]> buffer; // holds the file if it could not be mapped
+
+    /* hash value used for the buckets, mixed unless the hasher is avalanching (like ADS_flat_set) */
+    static size_type hash(const key_type &key)
+    {
+        if constexpr (ADS_is_avalanching<hasher>::value)
+        {
+            return hasher{}(key);
+        }
+        else
+        {
+            return ADS_mix(hasher{}(key));
+        }
+    }
+
+    /* Maps (or reads) the file path and points data to its contents */
+    void load(const std::string &path);
+
+    /* Checks that the header belongs to a snapshot of key_type, that all sections fit into the file and that every bucket's keys do */
+    void validate();
+
+    void unload() noexcept;
+
+public:
+    /* ------- CONSTRUCTORS ------- */
+
+    /*
+    Opens the snapshot file path. Only the header and the bucket offsets are checked (see verify() for the checksum). Complexity: O(bucket_count)
+    Throws std::runtime_error if the file cannot be opened or is not a snapshot of key_type.
+    */
+    explicit ADS_set_view(const std::string &path)
+    {
+        load(path);
+        try
+        {
+            validate();
+        }
+        catch (...)
+        {
+            unload();
+            throw;
+        }
+    }
+
+    ADS_set_view(ADS_set_view &&other) noexcept
+    {
+        swap(other);
+    }
+
+    ADS_set_view &operator=(ADS_set_view &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unload();
+            swap(other);
+        }
+        return *this;
+    }
+
+    /* a mapping is owned by exactly one view */
+    ADS_set_view(const ADS_set_view &) = delete;
+    ADS_set_view &operator=(const ADS_set_view &) = delete;
+
+    ~ADS_set_view()
+    {
+        unload();
+    }
+
+    /* ------- PUBLIC METHODS ------- */
+
+    size_type size() const
+    {
+        return header->element_count;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /*
+    Return value: pointer to the stored key, or end() if key is not stored.
+    Reads one offset pair and the keys of one bucket.
+    */
+    const_iterator find(const key_type &key) const
+    {
+        size_type bucket{hash(key) & (header->bucket_count - 1)};
+        for (const key_type *keyPtr{keys + offsets[bucket]}, *bucket_end{keys + offsets[bucket + 1]}; keyPtr != bucket_end; ++keyPtr)
+        {
+            if (key_equal{}(*keyPtr, key))
+            {
+                return keyPtr;
+            }
+        }
+        return end();
+    }
+
+    size_type count(const key_type &key) const
+    {
+        return find(key) != end();
+    }
+
+    const_iterator begin() const
+    {
+        return keys;
+    }
+
+    const_iterator end() const
+    {
+        return keys + size();
+    }
+
+    /*
+    Return value: true if the checksum of the file matches the one in its header. Reads the whole file.
+    */
+    bool verify() const
+    {
+        return ADS_snapshot_checksum(data + sizeof(ADS_snapshot_header), data_size - sizeof(ADS_snapshot_header)) == header->checksum;
+    }
+
+    void swap(ADS_set_view &other) noexcept
+    {
+        std::swap(data, other.data);
+        std::swap(data_size, other.data_size);
+        std::swap(header, other.header);
+        std::swap(offsets, other.offsets);
+        std::swap(keys, other.keys);
+        buffer.swap(other.buffer);
+    }
+
+    /*
+    Output the buckets and their keys to the stream o
+    */
+    void dump(std::ostream &o = std::cerr) const;
+
+    /*
+    Writes a snapshot of the keys of set to o (which has to be opened in binary mode)
+    */
+    template <typename Set>
+    static void write(const Set &set, std::ostream &o);
+};
+
+/* ------- SNAPSHOT VIEW PRIVATE METHODS IMPLEMENTATION ------- */
+template <typename Key, typename Hash, typename KeyEqual>
+void ADS_set_view<Key, Hash, KeyEqual>::load(const std::string &path)
+{
+#ifdef ADS_SET_VIEW_MMAP
+    int file{::open(path.c_str(), O_RDONLY)};
+    if (file < 0)
+    {
+        throw std::runtime_error("ADS_set_view: cannot open " + path);
+    }
+    struct stat file_status;
+    if (::fstat(file, &file_status) != 0 || file_status.st_size < off_t(sizeof(ADS_snapshot_header)))
+    {
+        ::close(file);
+        throw std::runtime_error("ADS_set_view: " + path + " is not a snapshot");
+    }
+    data_size = size_type(file_status.st_size);
+    void *mapping{::mmap(nullptr, data_size, PROT_READ, MAP_SHARED, file, 0)};
+    ::close(file); // the mapping stays valid without the descriptor
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("ADS_set_view: cannot map " + path);
+    }
+    data = static_cast<const unsigned char *>(mapping);
+#else
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    if (!file)
+    {
+        throw std::runtime_error("ADS_set_view: cannot open " + path);
+    }
+    data_size = size_type(file.tellg());
+    if (data_size < sizeof(ADS_snapshot_header))
+    {
+        throw std::runtime_error("ADS_set_view: " + path + " is not a snapshot");
+    }
+    // 64 bit words, so that the offsets and the keys are aligned as in a mapping
+    buffer.reset(new uint64_t[(data_size + sizeof(uint64_t) - 1) / sizeof(uint64_t)]);
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(buffer.get()), std::streamsize(data_size));
+    if (!file)
+    {
+        buffer.reset();
+        throw std::runtime_error("ADS_set_view: cannot read " + path);
+    }
+    data = reinterpret_cast<const unsigned char *>(buffer.get());
+#endif
+}
+
+template <typename Key, typename Hash, typename KeyEqual>
+void ADS_set_view<Key, Hash, KeyEqual>::validate()
+{
+    header = reinterpret_cast<const ADS_snapshot_header *>(data);
+    if (std::memcmp(header->magic, ADS_snapshot_header::MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ADS_snapshot_header::VERSION || header->byte_order != ADS_snapshot_header::BYTE_ORDER_MARK)
+    {
+        throw std::runtime_error("ADS_set_view: not a snapshot or written by an incompatible version");
+    }
+    if (header->key_size != sizeof(key_type))
+    {
+        throw std::runtime_error("ADS_set_view: the snapshot holds keys of another type");
+    }
+    const uint64_t buckets{header->bucket_count};
+    const uint64_t offsets_end{sizeof(ADS_snapshot_header) + (buckets + 1) * sizeof(uint64_t)};
+    /* the keys have to fit behind keys_offset, divided instead of multiplied so a damaged element_count cannot overflow */
+    if (buckets == 0 || (buckets & (buckets - 1)) != 0 || buckets > data_size || offsets_end > header->keys_offset ||
+        header->keys_offset % alignof(key_type) != 0 || header->keys_offset > data_size ||
+        header->element_count > (data_size - header->keys_offset) / sizeof(key_type))
+    {
+        throw std::runtime_error("ADS_set_view: the snapshot is truncated or damaged");
+    }
+    offsets = reinterpret_cast<const uint64_t *>(data + sizeof(ADS_snapshot_header));
+    keys = reinterpret_cast<const key_type *>(data + header->keys_offset);
+    /* find() reads keys[offsets[bucket] .. offsets[bucket + 1][, so the offsets must never decrease or point behind the keys */
+    if (offsets[0] != 0 || offsets[buckets] != header->element_count)
+    {
+        throw std::runtime_error("ADS_set_view: the snapshot is truncated or damaged");
+    }
+    for (uint64_t bucket{0}; bucket < buckets; ++bucket)
+    {
+        if (offsets[bucket] > offsets[bucket + 1])
+        {
+            throw std::runtime_error("ADS_set_view: the snapshot is truncated or damaged");
+        }
+    }
+}
+
+template <typename Key, typename Hash, typename KeyEqual>
+void ADS_set_view<Key, Hash, KeyEqual>::unload() noexcept
+{
+#ifdef ADS_SET_VIEW_MMAP
+    if (data)
+    {
+        ::munmap(const_cast<unsigned char *>(data), data_size);
+    }
+#endif
+    buffer.reset();
+    data = nullptr;
+    data_size = 0;
+    header = nullptr;
+    offsets = nullptr;
+    keys = nullptr;
+}
+
+template <typename Key, typename Hash, typename KeyEqual>
+void ADS_set_view<Key, Hash, KeyEqual>::dump(std::ostream &o) const
+{
+    o << "bucket_count = " << header->bucket_count << ", element_count = " << header->element_count << "\n";
+    for (size_type bucket{0}; bucket < header->bucket_count; ++bucket)
+    {
+        o << bucket << ": ";
+        if (offsets[bucket] == offsets[bucket + 1])
+        {
+            o << "--FREE \n";
+            continue;
+        }
+        o << "[";
+        for (uint64_t index{offsets[bucket]}; index < offsets[bucket + 1]; ++index)
+        {
+            o << keys[index] << (index + 1 < offsets[bucket + 1] ? " " : "");
+        }
+        o << "]\n";
+    }
+    o << "\n";
+}
+
+template <typename Key, typename Hash, typename KeyEqual>
+template <typename Set>
+void ADS_set_view<Key, Hash, KeyEqual>::write(const Set &set, std::ostream &o)
+{
+    ADS_snapshot_header new_header{};
+    std::memcpy(new_header.magic, ADS_snapshot_header::MAGIC, sizeof(new_header.magic));
+    new_header.version = ADS_snapshot_header::VERSION;
+    new_header.byte_order = ADS_snapshot_header::BYTE_ORDER_MARK;
+    new_header.key_size = sizeof(key_type);
+    new_header.element_count = set.size();
+    new_header.bucket_count = 1;
+    while (new_header.bucket_count < new_header.element_count) // about one key per bucket
+    {
+        new_header.bucket_count *= 2;
+    }
+    const size_type buckets{new_header.bucket_count};
+    const size_type offsets_end{sizeof(ADS_snapshot_header) + (buckets + 1) * sizeof(uint64_t)};
+    new_header.keys_offset = (offsets_end + alignof(key_type) - 1) / alignof(key_type) * alignof(key_type);
+
+    // everything after the header: offsets, padding, keys (counting sort of the keys by bucket)
+    std::vector<unsigned char> body(new_header.keys_offset - sizeof(ADS_snapshot_header) + set.size() * sizeof(key_type));
+    std::vector<uint64_t> positions(buckets + 1);
+    for (const auto &key : set)
+    {
+        ++positions[(hash(key) & (buckets - 1)) + 1];
+    }
+    for (size_type bucket{0}; bucket < buckets; ++bucket)
+    {
+        positions[bucket + 1] += positions[bucket];
+    }
+    std::memcpy(body.data(), positions.data(), positions.size() * sizeof(uint64_t));
+    unsigned char *key_data{body.data() + (new_header.keys_offset - sizeof(ADS_snapshot_header))};
+    for (const auto &key : set)
+    {
+        std::memcpy(key_data + positions[hash(key) & (buckets - 1)]++ * sizeof(key_type), &key, sizeof(key_type));
+    }
+    new_header.checksum = ADS_snapshot_checksum(body.data(), body.size());
+
+    o.write(reinterpret_cast<const char *>(&new_header), sizeof(new_header));
+    o.write(reinterpret_cast<const char *>(body.data()), std::streamsize(body.size()));
+    if (!o)
+    {
+        throw std::runtime_error("write_snapshot: writing the snapshot failed");
+    }
+}
+
+/*
+Writes a snapshot of set to o (opened in binary mode), it can be opened with ADS_set_view<Key, Hash, KeyEqual>
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void write_snapshot(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &set, std::ostream &o)
+{
+    ADS_set_view<Key, Hash, KeyEqual>::write(set, o);
+}
+
+/*
+Writes a snapshot of set to the file path
+*/
+template <typename Key, size_t N, typename Hash, typename KeyEqual, typename Allocator, typename Storage>
+void write_snapshot(const ADS_set<Key, N, Hash, KeyEqual, Allocator, Storage> &set, const std::string &path)
+{
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file)
+    {
+        throw std::runtime_error("write_snapshot: cannot open " + path);
+    }
+    write_snapshot(set, static_cast<std::ostream &>(file));
+}
+
+/* moves only swap pointers */
+static_assert(std::is_nothrow_move_constructible<ADS_set_view<int>>::value && std::is_nothrow_move_assignable<ADS_set_view<int>>::value,
+              "ADS_set_view: move has to be noexcept");
+
+#endif // ADS_SET_VIEW_H
@@ -0,0 +1,416 @@
+/*
+-----------------
+BENCHMARK
+-----------------
+Measures ADS_set (separate chaining), ADS_flat_set, std::unordered_set and std::set side by side:
+insert, find-hit, find-miss, erase, iterate, copy and clear in ns per key, heap allocations per key for insert and copy,
+and the peak heap of building the container. The peak RSS of the whole process is printed at the end.
+Key types: unsigned, std::string and Person. Key distributions:
+* uniform: the keys are scattered over the whole value range, lookups pick every key with the same probability
+* skewed: the keys are consecutive (0, 1, 2, ...), lookups follow a Zipf like distribution (a few keys get most lookups)
+Build and run with benchmark.sh.
+Usage: ads_set_bench [max_size] [uniform|skewed|all] [unsigned|string|person|all]
+(sizes 1000, 10000, ... up to max_size, default 1000000; 100000000 needs several GB of memory)
+-----------------
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define ADS_BENCH_RUSAGE
+#endif
+
+#include "../ADS_set.h"
+
+/* ------- KEY TYPES ------- */
+
+struct Person
+{
+    std::string name;
+    unsigned age;
+
+    bool operator==(const Person &other) const
+    {
+        return age == other.age && name == other.name;
+    }
+
+    bool operator<(const Person &other) const
+    {
+        return name < other.name || (name == other.name && age < other.age);
+    }
+};
+
+std::ostream &operator<<(std::ostream &o, const Person &person)
+{
+    return o << person.name << ":" << person.age;
+}
+
+namespace std
+{
+    template <>
+    struct hash<Person>
+    {
+        size_t operator()(const Person &person) const
+        {
+            return hash<string>{}(person.name) * 31 + person.age;
+        }
+    };
+}
+
+/* key number value as key of type T, different values give different keys */
+template <typename T>
+T makeKey(uint32_t value);
+
+template <>
+unsigned makeKey<unsigned>(uint32_t value)
+{
+    return value;
+}
+
+template <>
+std::string makeKey<std::string>(uint32_t value)
+{
+    return "key_" + std::to_string(value);
+}
+
+template <>
+Person makeKey<Person>(uint32_t value)
+{
+    return Person{"person_" + std::to_string(value / 100), value % 100};
+}
+
+/* ------- ALLOCATION COUNTING ------- */
+/*
+Every allocation of the process goes through these operators (the table of ADS_set does not use its allocator).
+The size of a block is stored in front of it, so the live heap and its peak are known at any time.
+The benchmark is single threaded, plain counters suffice.
+They are not inlined, otherwise GCC takes them for the built in operators and warns about the pointer arithmetic.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#define ADS_BENCH_NOINLINE __attribute__((noinline))
+#else
+#define ADS_BENCH_NOINLINE
+#endif
+
+namespace heap
+{
+    constexpr size_t HEADER{alignof(std::max_align_t)};
+    size_t allocations{0};
+    size_t live_bytes{0};
+    size_t peak_bytes{0};
+}
+
+ADS_BENCH_NOINLINE void *operator new(size_t size)
+{
+    void *block{std::malloc(size + heap::HEADER)};
+    if (!block)
+    {
+        throw std::bad_alloc{};
+    }
+    *static_cast<size_t *>(block) = size;
+    ++heap::allocations;
+    heap::live_bytes += size;
+    heap::peak_bytes = std::max(heap::peak_bytes, heap::live_bytes);
+    return static_cast<char *>(block) + heap::HEADER;
+}
+
+ADS_BENCH_NOINLINE void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+ADS_BENCH_NOINLINE void operator delete(void *ptr) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+    char *block{static_cast<char *>(ptr) - heap::HEADER};
+    heap::live_bytes -= *reinterpret_cast<size_t *>(block);
+    std::free(block);
+}
+
+ADS_BENCH_NOINLINE void operator delete[](void *ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+ADS_BENCH_NOINLINE void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+ADS_BENCH_NOINLINE void operator delete[](void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+/* ------- WORKLOAD ------- */
+
+/* results are added up here so that the compiler cannot drop the measured loops */
+volatile size_t sink;
+
+size_t touch(unsigned key) { return key; }
+size_t touch(const std::string &key) { return key.size(); }
+size_t touch(const Person &person) { return person.age; }
+
+/* bijection on 32 bit values, turns consecutive numbers into scattered ones without collisions */
+uint32_t scatter(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352dU;
+    value ^= value >> 15;
+    value *= 0x846ca68bU;
+    value ^= value >> 16;
+    return value;
+}
+
+/*
+The keys of one benchmark run: keys are inserted (in this order), hits are lookups of stored keys,
+misses are lookups of keys that are not stored
+*/
+template <typename T>
+struct Workload
+{
+    std::vector<T> keys;
+    std::vector<T> hits;
+    std::vector<T> misses;
+
+    Workload(size_t size, bool skewed)
+    {
+        std::mt19937_64 rng{size * 2 + skewed}; // the same workload on every run
+        keys.reserve(size);
+        misses.reserve(size);
+        for (uint32_t index{0}; index < size; ++index)
+        {
+            keys.push_back(makeKey<T>(skewed ? index : scatter(index)));
+            misses.push_back(makeKey<T>(skewed ? uint32_t(size + index) : scatter(uint32_t(size + index))));
+        }
+        hits.reserve(size);
+        std::uniform_real_distribution<double> unit{0, 1};
+        for (size_t index{0}; index < size; ++index)
+        {
+            // skewed: log-uniform rank, approximately Zipf with exponent 1
+            size_t rank{skewed ? size_t(std::exp(unit(rng) * std::log(double(size) + 1))) - 1 : size_t(rng() % size)};
+            hits.push_back(keys[std::min(rank, size - 1)]);
+        }
+        if (!skewed)
+        {
+            std::shuffle(misses.begin(), misses.end(), rng);
+        }
+    }
+};
+
+/* ------- MEASUREMENT ------- */
+
+using benchmark_clock = std::chrono::steady_clock;
+
+double nanoseconds(benchmark_clock::duration duration)
+{
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+/* every operation is repeated until it handled at least MIN_KEYS keys, so small sizes are measured as well */
+constexpr size_t MIN_KEYS{2000000};
+
+/*
+Results of one container: ns per key for every operation, allocations per key and the peak heap while inserting
+*/
+struct Row
+{
+    double insert{0}, find_hit{0}, find_miss{0}, erase{0}, iterate{0}, copy{0}, clear{0};
+    double insert_allocations{0}, copy_allocations{0};
+    size_t peak_bytes{0};
+};
+
+template <typename Set, typename T>
+Row measure(const Workload<T> &workload)
+{
+    const size_t size{workload.keys.size()};
+    const size_t rounds{std::max(size_t(1), MIN_KEYS / size)};
+    const double keys{double(size * rounds)};
+    Row row;
+    size_t total{0};
+
+    // insert: a new container every round, the one of the last round is kept for the other operations
+    Set set;
+    benchmark_clock::duration elapsed{0};
+    size_t allocations{0};
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        Set fresh;
+        size_t live_before{heap::live_bytes};
+        heap::peak_bytes = live_before;
+        size_t allocations_before{heap::allocations};
+        auto start{benchmark_clock::now()};
+        for (const T &key : workload.keys)
+        {
+            fresh.insert(key);
+        }
+        elapsed += benchmark_clock::now() - start;
+        allocations += heap::allocations - allocations_before;
+        row.peak_bytes = heap::peak_bytes - live_before;
+        if (round + 1 == rounds)
+        {
+            set.swap(fresh);
+        }
+    }
+    row.insert = nanoseconds(elapsed) / keys;
+    row.insert_allocations = double(allocations) / keys;
+
+    auto start{benchmark_clock::now()};
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        for (const T &key : workload.hits)
+        {
+            total += set.count(key);
+        }
+    }
+    row.find_hit = nanoseconds(benchmark_clock::now() - start) / keys;
+
+    start = benchmark_clock::now();
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        for (const T &key : workload.misses)
+        {
+            total += set.count(key);
+        }
+    }
+    row.find_miss = nanoseconds(benchmark_clock::now() - start) / keys;
+
+    start = benchmark_clock::now();
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        for (const T &key : set)
+        {
+            total += touch(key);
+        }
+    }
+    row.iterate = nanoseconds(benchmark_clock::now() - start) / keys;
+
+    // copy, erase and clear work on copies, only the operation itself is timed
+    elapsed = benchmark_clock::duration{0};
+    allocations = 0;
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        size_t allocations_before{heap::allocations};
+        start = benchmark_clock::now();
+        Set copy{set};
+        elapsed += benchmark_clock::now() - start;
+        allocations += heap::allocations - allocations_before;
+        total += copy.size();
+    }
+    row.copy = nanoseconds(elapsed) / keys;
+    row.copy_allocations = double(allocations) / keys;
+
+    elapsed = benchmark_clock::duration{0};
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        Set copy{set};
+        start = benchmark_clock::now();
+        for (const T &key : workload.keys)
+        {
+            total += copy.erase(key);
+        }
+        elapsed += benchmark_clock::now() - start;
+    }
+    row.erase = nanoseconds(elapsed) / keys;
+
+    elapsed = benchmark_clock::duration{0};
+    for (size_t round{0}; round < rounds; ++round)
+    {
+        Set copy{set};
+        start = benchmark_clock::now();
+        copy.clear();
+        elapsed += benchmark_clock::now() - start;
+        total += copy.size();
+    }
+    row.clear = nanoseconds(elapsed) / keys;
+
+    sink = total;
+    return row;
+}
+
+void printHeader()
+{
+    std::cout << std::left << std::setw(9) << "key" << std::setw(9) << "keys" << std::setw(11) << "size" << std::setw(15) << "container"
+              << std::right << std::setw(8) << "insert" << std::setw(10) << "find-hit" << std::setw(11) << "find-miss"
+              << std::setw(8) << "erase" << std::setw(9) << "iterate" << std::setw(8) << "copy" << std::setw(8) << "clear"
+              << std::setw(14) << "alloc/insert" << std::setw(12) << "alloc/copy" << std::setw(12) << "heap MB" << "\n";
+}
+
+void printRow(const char *key, bool skewed, size_t size, const char *container, const Row &row)
+{
+    std::cout << std::left << std::setw(9) << key << std::setw(9) << (skewed ? "skewed" : "uniform") << std::setw(11) << size
+              << std::setw(15) << container << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << row.insert << std::setw(10) << row.find_hit << std::setw(11) << row.find_miss
+              << std::setw(8) << row.erase << std::setw(9) << row.iterate << std::setw(8) << row.copy << std::setw(8) << row.clear
+              << std::setprecision(2) << std::setw(14) << row.insert_allocations << std::setw(12) << row.copy_allocations
+              << std::setw(12) << double(row.peak_bytes) / (1024 * 1024) << std::endl;
+}
+
+/* all containers for one key type, distribution and size */
+template <typename T>
+void benchmark(const char *key, bool skewed, size_t size)
+{
+    Workload<T> workload{size, skewed};
+    printRow(key, skewed, size, "ADS_set", measure<ADS_set<T>>(workload));
+    printRow(key, skewed, size, "ADS_flat_set", measure<ADS_flat_set<T>>(workload));
+    printRow(key, skewed, size, "unordered_set", measure<std::unordered_set<T>>(workload));
+    printRow(key, skewed, size, "std::set", measure<std::set<T>>(workload));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_size{argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : size_t(1000000)};
+    std::string distribution{argc > 2 ? argv[2] : "all"};
+    std::string key_type{argc > 3 ? argv[3] : "all"};
+
+    std::cout << "ns per key, allocations per key, peak heap while inserting\n";
+    printHeader();
+    for (bool skewed : {false, true})
+    {
+        if (distribution != "all" && distribution != (skewed ? "skewed" : "uniform"))
+        {
+            continue;
+        }
+        for (size_t size{1000}; size <= max_size; size *= 10)
+        {
+            if (key_type == "all" || key_type == "unsigned")
+            {
+                benchmark<unsigned>("unsigned", skewed, size);
+            }
+            if (key_type == "all" || key_type == "string")
+            {
+                benchmark<std::string>("string", skewed, size);
+            }
+            if (key_type == "all" || key_type == "person")
+            {
+                benchmark<Person>("Person", skewed, size);
+            }
+        }
+    }
+
+#ifdef ADS_BENCH_RUSAGE
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    std::cout << "peak RSS: " << usage.ru_maxrss / (1024 * 1024) << " MB\n"; // bytes
+#else
+    std::cout << "peak RSS: " << usage.ru_maxrss / 1024 << " MB\n"; // kilobytes
+#endif
+#endif
+    return 0;
+}
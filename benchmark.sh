@@ -0,0 +1,16 @@
+#!/bin/bash 
+
+file="bench/ads_set_bench";
+
+if [ -f "$file" ] ; then
+    rm "$file"
+fi
+
+# Optimized build without valgrind, every row compares ADS_set with std::unordered_set and std::set
+\g++ -Wall -Wextra -O3 -DNDEBUG -std=c++17 -pedantic-errors -pthread bench/ads_set_bench.cpp -o bench/ads_set_bench
+# with rehash and probe counters (ADS_set::stats()) compiled in
+# \g++ -Wall -Wextra -O3 -DNDEBUG -DADS_SET_STATS -std=c++17 -pedantic-errors -pthread bench/ads_set_bench.cpp -o bench/ads_set_bench
+
+# Arguments: max size (1000 ... 100000000), uniform|skewed|all, unsigned|string|person|all
+./bench/ads_set_bench 1000000 all all | tee bench_output.txt
+# ./bench/ads_set_bench 100000000 uniform unsigned | tee bench_output.txt